@@ -399,7 +399,7 @@ FileSystem::Remove(char *name)
        return FALSE;			 // file not found 
     }
 
-    if (synchDisk->vis_num[sector]) {
+    if (synchDisk->IsOpen(sector)) {
         printf("Delete file failed.\n");
         return false;
     }
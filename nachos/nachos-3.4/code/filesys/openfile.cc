@@ -34,7 +34,7 @@ OpenFile::OpenFile(int sector)
     //printf("ssss %d\n", hdr->sectorNumber);
     //hdr->Print();
     seekPosition = 0;
-    synchDisk->vis_num[hdr->sectorNumber]++;
+    rwLock = synchDisk->FileOpened(hdr->sectorNumber);
 }
 
 //----------------------------------------------------------------------
@@ -44,10 +44,35 @@ OpenFile::OpenFile(int sector)
 
 OpenFile::~OpenFile()
 {
-    synchDisk->vis_num[hdr->sectorNumber]--;
+    synchDisk->FileClosed(hdr->sectorNumber);
     delete hdr;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::HeaderSector
+// 	Return the disk sector holding the header of the file.  No two
+//	files have the same one, so it can be used as a key for caches of
+//	file contents, such as the shared text of executables.
+//----------------------------------------------------------------------
+
+int
+OpenFile::HeaderSector()
+{
+    return hdr->sectorNumber;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::Reopen
+// 	Return a new OpenFile for the same file, for a kernel object that
+//	must keep the file open after the user has closed it.
+//----------------------------------------------------------------------
+
+OpenFile *
+OpenFile::Reopen()
+{
+    return new OpenFile(hdr->sectorNumber);
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Seek
 // 	Change the current location within the open file -- the point at
@@ -78,11 +103,11 @@ OpenFile::Seek(int position)
 int
 OpenFile::Read(char *into, int numBytes)
 {
-    synchDisk->ReaderIn(hdr->sectorNumber);
+    rwLock->ReadAcquire();
     int result = ReadAt(into, numBytes, seekPosition);
     currentThread->Yield();
     seekPosition += result;
-    synchDisk->ReaderOut(hdr->sectorNumber);
+    rwLock->ReadRelease();
     return result;
 }
 
@@ -90,13 +115,13 @@ int
 OpenFile::Write(char *into, int numBytes)
 {
     //printf("write: %d\n", numBytes);
-    synchDisk->WriteBegin(hdr->sectorNumber);
+    rwLock->WriteAcquire();
     //printf("%s is writing!\n", currentThread->getName());
     int result = WriteAt(into, numBytes, seekPosition);
     currentThread->Yield();
     seekPosition += result;
     //printf("%s writing over!\n", currentThread->getName());
-    synchDisk->WriteDone(hdr->sectorNumber);
+    rwLock->WriteRelease();
     return result;
 }
 
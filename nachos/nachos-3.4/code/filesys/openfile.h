@@ -52,6 +52,11 @@ class OpenFile {
 		}
 
     int Length() { Lseek(file, 0, 2); return Tell(file); }
+
+    int HeaderSector() { return FileId(file); }	// no header sector in
+					// UNIX: use the inode number, which
+					// identifies the file just as well
+    OpenFile *Reopen() { return new OpenFile(Dup(file)); }
     
   private:
     int file;
@@ -60,6 +65,7 @@ class OpenFile {
 
 #else // FILESYS
 class FileHeader;
+class RWLock;
 
 class OpenFile {
   public:
@@ -87,9 +93,16 @@ class OpenFile {
 					// end of file, tell, lseek back 
 
 	int Print();
+
+    int HeaderSector();			// Sector of the file header, which
+					// identifies the file
+    OpenFile *Reopen();			// Open the same file again, with
+					// a position of its own
     
     FileHeader *hdr;			// Header for this file 
     int seekPosition;			// Current position within the file
+    RWLock *rwLock;			// Shared by every OpenFile for the
+					// file, see SynchDisk::FileOpened
 };
 
 #endif // FILESYS
@@ -46,15 +46,11 @@ SynchDisk::SynchDisk(char* name)
     semaphore = new Semaphore("synch disk", 0);
     lock = new Lock("synch disk lock");
     disk = new Disk(name, DiskRequestDone, (int) this);
-    for (int i = 0; i < NumSectors; i++) {
-        mutex[i] = new Semaphore("file mutex", 1);
-        reader_num[i] = 0;
-        vis_num[i] = 0;
-    }
     for (int i = 0; i < cache_size; i++) {
         cache[i].valid = false;
     }
-    readerLock = new Lock("reader lock");
+    fileLocks = NULL;
+    fileLocksLock = new Lock("file locks");
 }
 
 //----------------------------------------------------------------------
@@ -68,10 +64,13 @@ SynchDisk::~SynchDisk()
     delete disk;
     delete lock;
     delete semaphore;
-    for (int i = 0; i < NumSectors; i++) {
-        delete mutex[i];
+    while (fileLocks != NULL) {		// files still open at shutdown
+        FileLock *entry = fileLocks;
+
+        fileLocks = entry->next;
+        delete entry;
     }
-    delete readerLock;
+    delete fileLocksLock;
 }
 
 //----------------------------------------------------------------------
@@ -170,33 +169,72 @@ SynchDisk::RequestDone()
 }
 
 
-void SynchDisk::ReaderIn(int sector) {
-    readerLock->Acquire();
-    reader_num[sector]++;
-    if (reader_num[sector] == 1) {
-        mutex[sector]->P();
+//----------------------------------------------------------------------
+// SynchDisk::FileOpened
+// 	An OpenFile is created for a file.  Return the reader/writer lock
+//	of the file, creating it if the file was not open yet.
+//
+//	"sector" is the header sector of the file
+//----------------------------------------------------------------------
+
+RWLock *
+SynchDisk::FileOpened(int sector)
+{
+    FileLock *entry;
+
+    fileLocksLock->Acquire();
+    for (entry = fileLocks; entry != NULL; entry = entry->next)
+        if (entry->sector == sector)
+            break;
+    if (entry == NULL) {
+        entry = new FileLock(sector);
+        entry->next = fileLocks;
+        fileLocks = entry;
     }
-    //printf("%s ", currentThread->getName());
-    //printf("Reader in! Count of Reader: %d\n", reader_num[sector]);
-    readerLock->Release();
+    entry->openCount++;
+    fileLocksLock->Release();
+    return &entry->lock;
 }
 
-void SynchDisk::ReaderOut(int sector) {
-    readerLock->Acquire();
-    reader_num[sector]--;
-    if (reader_num[sector] == 0) {
-        mutex[sector]->V();
+//----------------------------------------------------------------------
+// SynchDisk::FileClosed
+// 	An OpenFile for a file is deleted.  When the file is no longer
+//	open at all, its lock goes too.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::FileClosed(int sector)
+{
+    FileLock **ptr, *entry;
+
+    fileLocksLock->Acquire();
+    for (ptr = &fileLocks; *ptr != NULL; ptr = &(*ptr)->next)
+        if ((*ptr)->sector == sector)
+            break;
+    ASSERT(*ptr != NULL);
+    entry = *ptr;
+    if (--entry->openCount == 0) {
+        *ptr = entry->next;
+        delete entry;
     }
-    //printf("%s ", currentThread->getName());
-    //printf("Reader out! Count of Reader: %d\n", reader_num[sector]);
-    readerLock->Release();
+    fileLocksLock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchDisk::IsOpen
+// 	Return TRUE if there is an OpenFile for a file, which must not be
+//	removed then.
+//----------------------------------------------------------------------
 
-void SynchDisk::WriteBegin(int sector) {
-    mutex[sector]->P();
-}
+bool
+SynchDisk::IsOpen(int sector)
+{
+    FileLock *entry;
 
-void SynchDisk::WriteDone(int sector) {
-    mutex[sector]->V();
-}
\ No newline at end of file
+    fileLocksLock->Acquire();
+    for (entry = fileLocks; entry != NULL; entry = entry->next)
+        if (entry->sector == sector)
+            break;
+    fileLocksLock->Release();
+    return entry != NULL;
+}
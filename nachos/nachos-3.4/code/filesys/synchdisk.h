@@ -25,6 +25,21 @@ class Cache {
     char data[SectorSize];
 };
 
+// Every file that is open has a reader/writer lock, shared by all of
+// its OpenFiles; the entry is created when the file is first opened,
+// and goes when it is last closed.
+
+class FileLock {
+  public:
+    FileLock(int headerSector) : lock("file lock") {
+	sector = headerSector; openCount = 0; next = NULL; }
+
+    int sector;				// header sector of the file
+    int openCount;			// OpenFiles for the file
+    RWLock lock;			// readers and writers of the file
+    FileLock *next;
+};
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -52,12 +67,10 @@ class SynchDisk {
     void RequestDone();			// Called by the disk device interrupt
 					// handler, to signal that the
 					// current disk operation is complete.
-    void ReaderIn(int sector);
-    void ReaderOut(int sector);
-    void WriteBegin(int sector);
-    void WriteDone(int sector);
-
-    int vis_num[NumSectors];
+    RWLock *FileOpened(int sector);	// A file is opened; return the lock
+					// its readers and writers share
+    void FileClosed(int sector);	// An OpenFile for it is deleted
+    bool IsOpen(int sector);		// Is the file open at all?
 
   private:
     Disk *disk;		  		// Raw disk device
@@ -65,9 +78,8 @@ class SynchDisk {
 					// with the interrupt handler
     Lock *lock;		  		// Only one read/write request
 					// can be sent to the disk at a time
-    Semaphore *mutex[NumSectors];
-    int reader_num[NumSectors];
-    Lock *readerLock;
+    FileLock *fileLocks;		// the files that are open
+    Lock *fileLocksLock;		// protects the list
     Cache cache[cache_size];
 };
 
@@ -134,7 +134,6 @@ Console::GetChar()
     lock->Acquire();
     char ch = incoming;
     incoming = EOF;
-    (*readHandler)(handlerArg);	
     lock->Release();
     return ch;
 }
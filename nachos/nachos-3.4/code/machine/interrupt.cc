@@ -23,13 +23,14 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "system.h"
+#include "synch.h"
 #include <stdio.h>
 
 // String definitions for debugging messages
 
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "network send", "network recv", "alarm"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -61,7 +62,6 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -74,9 +74,12 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-	delete (PendingInterrupt *)pending->Remove();
-    delete pending;
+    PendingInterrupt *pend;
+
+    while ((pend = pending.Remove()) != NULL)
+	delete pend;
+    while ((pend = unused.Remove()) != NULL)
+	delete pend;
 }
 
 //----------------------------------------------------------------------
@@ -177,6 +180,11 @@ Interrupt::OneTick()
 	currentThread->Yield();
 	status = old;
     }
+    if (smp != NULL && stats->totalTicks >= smp->QuantumEnd()) {
+	status = SystemMode;		// let the other CPUs catch up
+	smp->EndQuantum(old == UserMode);
+	status = old;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -234,6 +242,56 @@ Interrupt::Idle()
     Halt();
 }
 
+//----------------------------------------------------------------------
+// Interrupt::IdleUntil
+// 	Routine called on a multiprocessor, when the CPU being simulated
+//	has nothing to run, but the others may have.
+//
+//	Roll simulated time forward until the next scheduled interrupt,
+//	and take it, but not past "limit", when the CPU is to make way
+//	for the others.  Unlike Idle, never stop: the other CPUs may
+//	still make something happen, so a timer interrupt is taken as
+//	usual, rather than taken as the end of the simulation.
+//
+// Returns:
+//	TRUE, if we fired off any interrupt handlers
+//----------------------------------------------------------------------
+bool
+Interrupt::IdleUntil(int limit)
+{
+    PendingInterrupt *next = pending.Head();
+    bool fired = FALSE;
+
+    DEBUG('i', "CPU idling until %d; checking for interrupts.\n", limit);
+    status = SystemMode;
+    if (next != NULL && next->when <= limit) {
+	fired = CheckIfDue(TRUE);	// advance the clock to it
+	while (CheckIfDue(FALSE))	// and take any other due then
+	    ;
+	yieldOnReturn = FALSE;		// the CPU is looking for something
+					// to run anyway
+    } else if (limit > stats->totalTicks) {
+	stats->idleTicks += limit - stats->totalTicks;
+	stats->totalTicks = limit;
+    }
+    return fired;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::NextPending
+// 	Return the time the next scheduled interrupt is due, -1 if none
+//	is scheduled.  Until then, no interrupt handler runs, so the CPUs
+//	of a multiprocessor may run user code in parallel.
+//----------------------------------------------------------------------
+
+int
+Interrupt::NextPending()
+{
+    PendingInterrupt *next = pending.Head();
+
+    return (next == NULL) ? -1 : next->when;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Halt
 // 	Shut down Nachos cleanly, printing out performance statistics.
@@ -243,6 +301,10 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    if (smp != NULL)
+	smp->Print();
+    if (SynchStat::enabled)
+	SynchStat::PrintAll();
     Cleanup();     // Never returns.
 }
 
@@ -266,15 +328,22 @@ void
 Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
-
-    //printf("oooooop\n");
+    PendingInterrupt *toOccur = unused.Remove();
+
+    if (toOccur == NULL) {
+	toOccur = new PendingInterrupt(handler, arg, when, type);
+    } else {				// recycle one that has fired
+	toOccur->handler = handler;
+	toOccur->arg = arg;
+	toOccur->when = when;
+	toOccur->type = type;
+    }
 
     DEBUG('i', "Scheduling interrupt handler the %s at time = %d\n", 
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending.SortedInsert(toOccur, when);
 }
 
 //----------------------------------------------------------------------
@@ -300,8 +369,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
+    PendingInterrupt *toOccur = pending.SortedRemove(&when);
 
     if (toOccur == NULL)		// no pending interrupts
 	return FALSE;			
@@ -310,14 +378,14 @@ Interrupt::CheckIfDue(bool advanceClock)
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
     } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+	pending.SortedInsert(toOccur, when);
 	return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+				&& pending.IsEmpty()) {
+	 pending.SortedInsert(toOccur, when);
 	 return FALSE;
     }
 
@@ -334,7 +402,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
     status = old;				// restore the machine status
     inHandler = FALSE;
-    delete toOccur;
+    unused.Prepend(toOccur);
     return TRUE;
 }
 
@@ -345,10 +413,8 @@ Interrupt::CheckIfDue(bool advanceClock)
 //----------------------------------------------------------------------
 
 static void
-PrintPending(int arg)
+PrintPending(PendingInterrupt *pend)
 {
-    PendingInterrupt *pend = (PendingInterrupt *)arg;
-
     printf("Interrupt handler %s, scheduled at %d\n", 
 	intTypeNames[pend->type], pend->when);
 }
@@ -366,7 +432,7 @@ Interrupt::DumpState()
 					intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
-    pending->Mapcar(PrintPending);
+    pending.Mapcar(PrintPending);
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
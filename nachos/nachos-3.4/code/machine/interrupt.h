@@ -36,7 +36,7 @@
 #define INTERRUPT_H
 
 #include "copyright.h"
-#include "list.h"
+#include "ilist.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -50,11 +50,15 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 // In Nachos, we support a hardware timer device, a disk, a console
 // display and keyboard, and a network.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				NetworkSendInt, NetworkRecvInt};
+				NetworkSendInt, NetworkRecvInt, AlarmInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
 // left public to make it simpler to manipulate.
+//
+// Interrupts are linked into the pending list through a field of
+// their own, and recycled once they have fired, so that scheduling
+// an interrupt does not allocate memory once the simulation is warm.
 
 class PendingInterrupt {
   public:
@@ -67,6 +71,7 @@ class PendingInterrupt {
     int arg;                    // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    ListLink<PendingInterrupt> link;	// on the pending or free list
 };
 
 // The following class defines the data structures for the simulation
@@ -89,6 +94,11 @@ class Interrupt {
     void Idle(); 			// The ready queue is empty, roll 
 					// simulated time forward until the 
 					// next interrupt
+    bool IdleUntil(int limit);		// One CPU of several has nothing
+					// to do: roll time forward, but
+					// not past "limit"
+    int NextPending();			// When the next interrupt is due,
+					// -1 if none is
 
     void Halt(); 			// quit and print out stats
     
@@ -114,8 +124,12 @@ class Interrupt {
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
+    IntrusiveList<PendingInterrupt, &PendingInterrupt::link> pending;
+				// the list of interrupts scheduled
 				// to occur in the future
+    IntrusiveList<PendingInterrupt, &PendingInterrupt::link> unused;
+				// interrupts that have fired, to be
+				// reused by Schedule
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
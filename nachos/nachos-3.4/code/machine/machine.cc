@@ -80,9 +80,36 @@ Machine::Machine(bool debug)
 #endif
 
     singleStep = debug;
+    parallel = trapped = FALSE;
+    sharesMemory = FALSE;
     CheckEndian();
 }
 
+//----------------------------------------------------------------------
+// Machine::Machine
+// 	Initialize another CPU of a multiprocessor, to run user code in
+//	parallel with the others.  It has registers of its own, but the
+//	main memory of "shared"; its TLB and page table are set by the
+//	kernel before each run.
+//----------------------------------------------------------------------
+
+Machine::Machine(Machine *shared)
+{
+    for (int i = 0; i < NumTotalRegs; i++)
+        registers[i] = 0;
+    mainMemory = shared->mainMemory;
+    bitmap = shared->bitmap;
+    end = 0;
+    tlb = NULL;
+    pageTable = NULL;
+    pageTableSize = 0;
+    TLBhit = TLBmiss = 0;
+    singleStep = FALSE;
+    parallel = TRUE;
+    trapped = FALSE;
+    sharesMemory = TRUE;
+}
+
 //----------------------------------------------------------------------
 // Machine::~Machine
 // 	De-allocate the data structures used to simulate user program execution.
@@ -90,6 +117,8 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
+    if (sharesMemory)			// the TLB is not ours either
+	return;
     delete [] mainMemory;
     if (tlb != NULL)
         delete [] tlb;
@@ -108,6 +137,10 @@ Machine::~Machine()
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    if (parallel) {			// leave the instruction undone,
+	trapped = TRUE;			// for the kernel to run it again
+	return;
+    }
     DEBUG('m', "Exception: %s\n", exceptionNames[which]);
     
 //  ASSERT(interrupt->getStatus() == UserMode);
@@ -99,7 +99,7 @@ class Bitmap {
 		int map[NumPhysPages];
 };
 
-
+class PageTable;
 
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
@@ -118,6 +118,9 @@ class Machine {
   public:
     Machine(bool debug);	// Initialize the simulation of the hardware
 				// for running user programs
+    Machine(Machine *shared);	// Initialize another CPU of the same
+				// machine, sharing the memory of "shared",
+				// to run user code in parallel with it
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -191,14 +194,24 @@ class Machine {
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
 
-    TranslationEntry *pageTable;
+    PageTable *pageTable;		// page table of the current address
+					// space, see userprog/pagetable.h
     unsigned int pageTableSize;
 	int TLBhit;
 	int TLBmiss;
 	Bitmap *bitmap;
 	int end;
 
+// For a CPU running user code in parallel with the others (see
+// threads/cpu.h), an exception does not trap to the kernel, which runs
+// on one CPU at a time.  Instead, the instruction is left undone, with
+// "trapped" set, and the kernel runs it again later, one CPU at a time.
+
+    bool parallel;		// running in parallel with other CPUs
+    bool trapped;		// an instruction was left undone
+
   private:
+    bool sharesMemory;		// "mainMemory" belongs to another Machine
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
@@ -106,7 +106,7 @@ Machine::OneInstruction(Instruction *instr)
 				// in the future
 
     // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    if (!ReadMem(registers[PCReg], 4, &raw))
 		return;			// exception occurred
 		
     instr->value = raw;
@@ -239,7 +239,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_LB:
       case OP_LBU:
 	tmp = registers[instr->rs] + instr->extra;
-	if (!machine->ReadMem(tmp, 1, &value))
+	if (!ReadMem(tmp, 1, &value))
 	    return;
 
 	if ((value & 0x80) && (instr->opCode == OP_LB))
@@ -257,7 +257,7 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 2, &value))
+	if (!ReadMem(tmp, 2, &value))
 	    return;
 
 	if ((value & 0x8000) && (instr->opCode == OP_LH))
@@ -279,7 +279,7 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
@@ -293,7 +293,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
@@ -324,7 +324,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
@@ -389,13 +389,13 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SB:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
 	    return;
 	break;
 	
       case OP_SH:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
 	    return;
 	break;
@@ -477,7 +477,7 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SW:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
 	    return;
 	break;
@@ -489,7 +489,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMem((tmp & ~0x3), 4, &value))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -508,7 +508,7 @@ Machine::OneInstruction(Instruction *instr)
 					    0xff);
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMem((tmp & ~0x3), 4, value))
 	    return;
 	break;
     	
@@ -519,7 +519,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMem((tmp & ~0x3), 4, &value))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -535,7 +535,7 @@ Machine::OneInstruction(Instruction *instr)
 	    value = registers[instr->rt];
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMem((tmp & ~0x3), 4, value))
 	    return;
 	break;
     	
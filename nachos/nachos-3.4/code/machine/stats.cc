@@ -21,7 +21,39 @@ Statistics::Statistics()
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
-    numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPageFaults = numSuspends = numPacketsSent = numPacketsRecvd = 0;
+    numInversions = inversionTicks = 0;
+    for (int i = 0; i < MaxSyscalls; i++) {
+	numSyscalls[i] = syscallTicks[i] = 0;
+	for (int b = 0; b < LatencyBuckets; b++)
+	    syscallLatency[i][b] = 0;
+	syscallName[i] = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::SyscallDone
+// 	Record how long a system call took, in simulated ticks, from the
+//	trap to the return to user mode.  The call itself was counted in
+//	numSyscalls when it started; calls that never return (Exit, Halt)
+//	are counted there, but have no latency.
+//
+//	"type" is the system call code
+//	"ticks" is the time it took
+//----------------------------------------------------------------------
+
+void
+Statistics::SyscallDone(int type, int ticks)
+{
+    int bucket = 0;
+
+    ASSERT(type >= 0 && type < MaxSyscalls);
+    syscallTicks[type] += ticks;
+    while (ticks > 0 && bucket < LatencyBuckets - 1) {
+	ticks >>= 1;
+	bucket++;
+    }
+    syscallLatency[type][bucket]++;
 }
 
 //----------------------------------------------------------------------
@@ -38,7 +70,31 @@ Statistics::Print()
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
-    printf("Paging: faults %d\n", numPageFaults);
+    printf("Paging: faults %d, suspends %d\n", numPageFaults, numSuspends);
+    printf("Priority inversions: %d, waiting %d ticks\n", numInversions,
+	inversionTicks);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    for (int i = 0; i < MaxSyscalls; i++) {
+	int returned = 0;
+
+	if (numSyscalls[i] == 0)
+	    continue;
+	for (int b = 0; b < LatencyBuckets; b++)
+	    returned += syscallLatency[i][b];
+	printf("Syscall %s: calls %d, average %d ticks\n",
+	    syscallName[i] != NULL ? syscallName[i] : "?", numSyscalls[i],
+	    returned > 0 ? syscallTicks[i] / returned : 0);
+	for (int b = 0; b < LatencyBuckets; b++) {
+	    if (syscallLatency[i][b] == 0)
+		continue;
+	    if (b == 0)
+		printf("\t0 ticks: %d\n", syscallLatency[i][b]);
+	    else if (b == LatencyBuckets - 1)
+		printf("\t%d+ ticks: %d\n", 1 << (b - 1), syscallLatency[i][b]);
+	    else
+		printf("\t%d-%d ticks: %d\n", 1 << (b - 1), (1 << b) - 1,
+		    syscallLatency[i][b]);
+	}
+    }
 }
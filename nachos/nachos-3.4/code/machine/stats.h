@@ -13,6 +13,12 @@
 
 #include "copyright.h"
 
+#define MaxSyscalls	32	// system call codes we keep statistics for
+#define LatencyBuckets	16	// latency histogram buckets: bucket 0 counts
+				// calls that took no time, bucket i > 0 those
+				// that took [2^(i-1), 2^i) ticks; the last one
+				// also counts anything longer
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -33,11 +39,25 @@ class Statistics {
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numSuspends;		// number of processes swapped out to
+				// stop thrashing
+    int numInversions;		// lock acquisitions held up by a less
+				// urgent thread
+    int inversionTicks;		// time spent waiting in those
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
+    int numSyscalls[MaxSyscalls];	// calls of each system call
+    int syscallTicks[MaxSyscalls];	// total time spent in each, for
+					// the calls that returned
+    int syscallLatency[MaxSyscalls][LatencyBuckets];
+					// histogram of the time each took
+    char *syscallName[MaxSyscalls];	// for printing; set by the kernel
+
     Statistics(); 		// initialize everything to zero
 
+    void SyscallDone(int type, int ticks);
+				// record the latency of a system call
     void Print();		// print collected statistics
 };
 
@@ -35,6 +35,8 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 #ifdef HOST_i386
 #include <unistd.h>
 #include <sys/time.h>
@@ -265,6 +267,36 @@ Unlink(char *name)
     return unlink(name);
 }
 
+//----------------------------------------------------------------------
+// FileId
+// 	Return a number identifying an open file: its inode number.
+//	Two descriptors for the same file give the same number.
+//----------------------------------------------------------------------
+
+int
+FileId(int fd)
+{
+    struct stat buf;
+    int retVal = fstat(fd, &buf);
+
+    ASSERT(retVal >= 0);
+    return (int) buf.st_ino;
+}
+
+//----------------------------------------------------------------------
+// Dup
+// 	Return a second descriptor for an open file.  Abort on error.
+//----------------------------------------------------------------------
+
+int
+Dup(int fd)
+{
+    int newFd = dup(fd);
+
+    ASSERT(newFd >= 0);
+    return newFd;
+}
+
 //----------------------------------------------------------------------
 // OpenSocket
 // 	Open an interprocess communication (IPC) connection.  For now, 
@@ -461,6 +493,87 @@ Random()
     return rand();
 }
 
+// The host threads that RunInParallel hands calls out to, and the
+// calls being handed out.
+
+static pthread_mutex_t workLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t workReady = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t workDone = PTHREAD_COND_INITIALIZER;
+static VoidFunctionPtr workFunc;	// the function to call
+static int *workArgs;			// its argument, for each call
+static int workCount;			// the number of calls
+static int workNext;			// the next call to hand out
+static int workLeft;			// calls not finished yet
+static int numWorkers;			// host threads started so far
+
+//----------------------------------------------------------------------
+// Worker
+// 	Body of a host thread started by RunInParallel: make the calls
+//	handed out to it, and wait for more.
+//----------------------------------------------------------------------
+
+static void *
+Worker(void *)
+{
+    int call;
+
+    pthread_mutex_lock(&workLock);
+    for (;;) {
+	while (workNext >= workCount)
+	    pthread_cond_wait(&workReady, &workLock);
+	call = workNext++;
+	pthread_mutex_unlock(&workLock);
+	(*workFunc)(workArgs[call]);
+	pthread_mutex_lock(&workLock);
+	if (--workLeft == 0)
+	    pthread_cond_signal(&workDone);
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// RunInParallel
+// 	Call "func" once for each of the "count" arguments in "args",
+//	each call on a host thread of its own, and return when they have
+//	all returned.  The calling thread makes calls too; the other
+//	host threads are started the first time they are needed, and
+//	then kept waiting for more work.
+//
+//	"func" runs alongside the rest of Nachos, which is not written
+//	for that: it may only touch data that nothing else uses until
+//	RunInParallel returns.
+//----------------------------------------------------------------------
+
+void
+RunInParallel(VoidFunctionPtr func, int *args, int count)
+{
+    pthread_t thread;
+    int call;
+
+    pthread_mutex_lock(&workLock);
+    for (; numWorkers < count - 1; numWorkers++) {
+	call = pthread_create(&thread, NULL, Worker, NULL);
+	ASSERT(call == 0);
+	pthread_detach(thread);
+    }
+    workFunc = func;
+    workArgs = args;
+    workCount = count;
+    workNext = 0;
+    workLeft = count;
+    pthread_cond_broadcast(&workReady);
+    while (workNext < workCount) {	// lend a hand
+	call = workNext++;
+	pthread_mutex_unlock(&workLock);
+	(*func)(args[call]);
+	pthread_mutex_lock(&workLock);
+	workLeft--;
+    }
+    while (workLeft > 0)
+	pthread_cond_wait(&workDone, &workLock);
+    pthread_mutex_unlock(&workLock);
+}
+
 //----------------------------------------------------------------------
 // AllocBoundedArray
 // 	Return an array, with the two pages just before 
@@ -28,6 +28,8 @@ extern void Lseek(int fd, int offset, int whence);
 extern int Tell(int fd);
 extern void Close(int fd);
 extern bool Unlink(char *name);
+extern int FileId(int fd);
+extern int Dup(int fd);
 
 // Interprocess communication operations, for simulating the network
 extern int OpenSocket();
@@ -50,6 +52,10 @@ extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 extern void RandomInit(unsigned seed);
 extern int Random();
 
+// Call a function on several host threads at once, for simulating
+// several CPUs in parallel
+extern void RunInParallel(VoidFunctionPtr func, int *args, int count);
+
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
 extern char *AllocBoundedArray(int size);
@@ -96,22 +96,22 @@ Machine::ReadMem(int addr, int size, int *value)
     
     exception = Translate(addr, &physicalAddress, size, FALSE);
     if (exception != NoException) {
-		machine->RaiseException(exception, addr);
+		RaiseException(exception, addr);
 		return FALSE;
     }
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = mainMemory[physicalAddress];
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned short *) &mainMemory[physicalAddress];
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned int *) &mainMemory[physicalAddress];
 	*value = WordToHost(data);
 	break;
 
@@ -145,21 +145,21 @@ Machine::WriteMem(int addr, int size, int value)
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
     if (exception != NoException) {
-		machine->RaiseException(exception, addr);
+		RaiseException(exception, addr);
 		return FALSE;
     }
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
+	*(unsigned short *) &mainMemory[physicalAddress]
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &machine->mainMemory[physicalAddress]
+	*(unsigned int *) &mainMemory[physicalAddress]
 		= WordToMachine((unsigned int) value);
 	break;
 	
@@ -219,21 +219,11 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 				virtAddr, pageTableSize);
 			return AddressErrorException;
 		}
-		/*
-		else if (!pageTable[vpn].valid) {
-			DEBUG('a', "virtual page # %d too large for page table size %d!\n", 
-				virtAddr, pageTableSize);
-			return PageFaultException;
-		}*/
-		int pos = -1;
-		for (int i = 0; i < NumPhysPages; i++) {
-			if (pageTable[i].virtualPage == vpn)
-				pos = i;
-		}
-		if (pos == -1) {
+		entry = pageTable->Lookup(vpn);
+		if (entry == NULL || !entry->valid) {
+			DEBUG('a', "virtual page # %d not in memory!\n", vpn);
 			return PageFaultException;
 		}
-		entry = &pageTable[pos];
     }
 	else {
 		// scan the TLB to find the entry
@@ -268,6 +258,10 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 		DEBUG('a', "%d mapped read-only at %d in TLB!\n", virtAddr, i);
 		return ReadOnlyException;
     }
+    if (entry->shared && writing && parallel) {	// other CPUs may be
+	DEBUG('a', "store to shared page %d left undone\n", vpn);
+	return PageFaultException;		// using the page: leave the
+    }						// store until they are not
     pageFrame = entry->physicalPage;
 
     // if the pageFrame is too big, there is something really wrong! 
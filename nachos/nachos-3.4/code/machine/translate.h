@@ -40,6 +40,9 @@ class TranslationEntry {
 			// page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
+    bool shared;	// If this bit is set, other address spaces may
+			// modify the page too, so a CPU running in parallel
+			// with the others must not (see Machine::Translate).
     int cnt;
 };
 
@@ -51,7 +51,7 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 
 MailBox::MailBox()
 { 
-    messages = new SynchList(); 
+    messages = new SynchQueue<Mail *>;
 }
 
 //----------------------------------------------------------------------
@@ -101,7 +101,7 @@ MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 { 
     Mail *mail = new Mail(pktHdr, mailHdr, data); 
 
-    messages->Append((void *)mail);	// put on the end of the list of 
+    messages->Put(mail);		// put on the end of the list of 
 					// arrived messages, and wake up 
 					// any waiters
 }
@@ -122,7 +122,7 @@ void
 MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
 { 
     DEBUG('n', "Waiting for mail in mailbox\n");
-    Mail *mail = (Mail *) messages->Remove();	// remove message from list;
+    Mail *mail = messages->Get();		// remove message from list;
 						// will wait if list is empty
 
     *pktHdr = mail->pktHdr;
@@ -87,7 +87,8 @@ class MailBox {
 				// mailbox (and wait if there is no message 
 				// to get!)
   private:
-    SynchList *messages;	// A mailbox is just a list of arrived messages
+    SynchQueue<Mail *> *messages;	// A mailbox is just a queue of
+					// arrived messages
 };
 
 // The following class defines a "Post Office", or a collection of 
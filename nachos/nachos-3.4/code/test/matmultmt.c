@@ -0,0 +1,63 @@
+/* matmultmt.c 
+ *    Matrix multiplication, split between several threads of one
+ *    process.
+ *
+ *    Each thread computes a band of rows of the result, in the shared
+ *    arrays; the main thread waits on a condition variable until all
+ *    of them are done.
+ */
+
+#include "syscall.h"
+
+#define Dim 	20
+#define NumThreads	4
+
+int A[Dim][Dim];
+int B[Dim][Dim];
+int C[Dim][Dim];
+
+int lock, allDone;	/* protect and signal "finished" */
+int finished;
+
+void
+multiply(int band)
+{
+    int i, j, k;
+
+    for (i = band; i < Dim; i += NumThreads)
+	for (j = 0; j < Dim; j++)
+            for (k = 0; k < Dim; k++)
+		 C[i][j] += A[i][k] * B[k][j];
+
+    LockAcquire(lock);
+    finished++;
+    CondSignal(allDone, lock);
+    LockRelease(lock);
+}
+
+int
+main()
+{
+    int i, j;
+
+    for (i = 0; i < Dim; i++)		/* first initialize the matrices */
+	for (j = 0; j < Dim; j++) {
+	     A[i][j] = i;
+	     B[i][j] = j;
+	     C[i][j] = 0;
+	}
+
+    lock = LockCreate();
+    allDone = CondCreate();
+    finished = 0;
+    for (i = 0; i < NumThreads; i++)	/* then multiply them together */
+	if (ThreadCreate(multiply, i) == -1)
+	    Exit(-1);
+
+    LockAcquire(lock);
+    while (finished < NumThreads)
+	CondWait(allDone, lock);
+    LockRelease(lock);
+
+    Exit(C[Dim-1][Dim-1]);		/* and then we're done */
+}
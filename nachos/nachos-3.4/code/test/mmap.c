@@ -0,0 +1,40 @@
+/* mmap.c
+ *	Simple program to test memory-mapped files.
+ *
+ *	Maps "a.txt", counts its newlines by scanning the mapped pages,
+ *	upper-cases the first character through the mapping, and unmaps
+ *	it, which writes the change back to the file.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    OpenFileId fd;
+    char name[6];
+    char *data;
+    int i, lines;
+
+    name[0] = 'a';
+    name[1] = '.';
+    name[2] = 't';
+    name[3] = 'x';
+    name[4] = 't';
+    name[5] = '\0';
+    fd = Open(name);
+    data = (char *) Mmap(fd, 0, 1024);
+    if ((int) data == -1)
+	Exit(1);
+    Close(fd);
+
+    lines = 0;
+    for (i = 0; i < 1024 && data[i] != '\0'; i++)
+	if (data[i] == '\n')
+	    lines++;
+    if (data[0] >= 'a' && data[0] <= 'z')
+	data[0] = data[0] - 'a' + 'A';
+
+    Munmap((int) data);
+    Exit(lines);
+}
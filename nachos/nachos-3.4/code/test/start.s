@@ -130,6 +130,152 @@ Yield:
 	j	$31
 	.end Yield
 
+	.globl Mmap
+	.ent	Mmap
+Mmap:
+	addiu $2,$0,SC_Mmap
+	syscall
+	j	$31
+	.end Mmap
+
+	.globl Munmap
+	.ent	Munmap
+Munmap:
+	addiu $2,$0,SC_Munmap
+	syscall
+	j	$31
+	.end Munmap
+
+	.globl ThreadCreate
+	.ent	ThreadCreate
+ThreadCreate:
+	la	$6,ThreadExit	/* where the new thread returns to */
+	addiu $2,$0,SC_ThreadCreate
+	syscall
+	j	$31
+	.end ThreadCreate
+
+	.globl ThreadExit
+	.ent	ThreadExit
+ThreadExit:
+	addiu $2,$0,SC_ThreadExit
+	syscall
+	j	$31
+	.end ThreadExit
+
+	.globl LockCreate
+	.ent	LockCreate
+LockCreate:
+	addiu $2,$0,SC_LockCreate
+	syscall
+	j	$31
+	.end LockCreate
+
+	.globl LockDestroy
+	.ent	LockDestroy
+LockDestroy:
+	addiu $2,$0,SC_LockDestroy
+	syscall
+	j	$31
+	.end LockDestroy
+
+	.globl LockAcquire
+	.ent	LockAcquire
+LockAcquire:
+	addiu $2,$0,SC_LockAcquire
+	syscall
+	j	$31
+	.end LockAcquire
+
+	.globl LockRelease
+	.ent	LockRelease
+LockRelease:
+	addiu $2,$0,SC_LockRelease
+	syscall
+	j	$31
+	.end LockRelease
+
+	.globl CondCreate
+	.ent	CondCreate
+CondCreate:
+	addiu $2,$0,SC_CondCreate
+	syscall
+	j	$31
+	.end CondCreate
+
+	.globl CondDestroy
+	.ent	CondDestroy
+CondDestroy:
+	addiu $2,$0,SC_CondDestroy
+	syscall
+	j	$31
+	.end CondDestroy
+
+	.globl CondWait
+	.ent	CondWait
+CondWait:
+	addiu $2,$0,SC_CondWait
+	syscall
+	j	$31
+	.end CondWait
+
+	.globl CondSignal
+	.ent	CondSignal
+CondSignal:
+	addiu $2,$0,SC_CondSignal
+	syscall
+	j	$31
+	.end CondSignal
+
+	.globl CondBroadcast
+	.ent	CondBroadcast
+CondBroadcast:
+	addiu $2,$0,SC_CondBroadcast
+	syscall
+	j	$31
+	.end CondBroadcast
+
+	.globl Pipe
+	.ent	Pipe
+Pipe:
+	addiu $2,$0,SC_Pipe
+	syscall
+	j	$31
+	.end Pipe
+
+	.globl RingSetup
+	.ent	RingSetup
+RingSetup:
+	addiu $2,$0,SC_RingSetup
+	syscall
+	j	$31
+	.end RingSetup
+
+	.globl RingSubmit
+	.ent	RingSubmit
+RingSubmit:
+	addiu $2,$0,SC_RingSubmit
+	syscall
+	j	$31
+	.end RingSubmit
+
+	.globl Sbrk
+	.ent	Sbrk
+Sbrk:
+	addiu $2,$0,SC_Sbrk
+	syscall
+	j	$31
+	.end Sbrk
+
+	.globl UpcallSetup
+	.ent	UpcallSetup
+UpcallSetup:
+	la	$5,ThreadExit	/* where upcalls return to */
+	addiu $2,$0,SC_UpcallSetup
+	syscall
+	j	$31
+	.end UpcallSetup
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
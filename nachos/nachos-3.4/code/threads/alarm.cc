@@ -0,0 +1,138 @@
+// alarm.cc
+//	Routines to wake up threads waiting with a time limit.
+//
+//	A thread woken by its alarm may be on the queue of the semaphore,
+//	lock or condition it waits on; since a thread is only ever on one
+//	ThreadQueue at a time, and its link records which, the alarm takes
+//	it off that queue in constant time.  A thread that was woken the
+//	normal way, but has not run yet to cancel its alarm, is left alone.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// AlarmHandler
+// 	Interrupt handler for the alarms.  Dummy function because C++
+//	does not allow a pointer to a member function.
+//
+//	"when" is the time the interrupt was scheduled for
+//----------------------------------------------------------------------
+
+static void
+AlarmHandler(int when)
+{
+    alarms->Expire(when);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize the timer service, with no alarm set.
+//----------------------------------------------------------------------
+
+Alarm::Alarm()
+{
+    nextInterrupt = -1;
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+// 	De-allocate the timer service.  Nobody may be waiting on an alarm.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    ASSERT(sleepers.IsEmpty());
+}
+
+//----------------------------------------------------------------------
+// Alarm::Set
+// 	Set an alarm for a thread about to sleep.  If it goes off before
+//	it is cancelled, the thread is made ready, and its "timedOut"
+//	flag set.
+//
+//	"thread" is the thread to wake up; its alarm must not be set
+//	"ticks" is how long from now, at least 1
+//----------------------------------------------------------------------
+
+void
+Alarm::Set(Thread *thread, int ticks)
+{
+    ASSERT(interrupt->getLevel() == IntOff && ticks > 0);
+    thread->timedOut = FALSE;
+    sleepers.SortedInsert(thread, stats->totalTicks + ticks);
+    Arm();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Cancel
+// 	Cancel the alarm of a thread, in constant time.  Does nothing if
+//	the alarm has gone off already.
+//----------------------------------------------------------------------
+
+void
+Alarm::Cancel(Thread *thread)
+{
+    ASSERT(interrupt->getLevel() == IntOff);
+    if (sleepers.Contains(thread))
+	sleepers.Unlink(thread);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Expire
+// 	Wake up every thread whose deadline has passed, and schedule an
+//	interrupt for the next deadline.
+//
+//	"when" is the time the interrupt was scheduled for
+//----------------------------------------------------------------------
+
+void
+Alarm::Expire(int when)
+{
+    Thread *thread;
+    ThreadQueue *queue;
+    int deadline;
+
+    if (when == nextInterrupt)
+	nextInterrupt = -1;
+    while (!sleepers.IsEmpty()) {
+	thread = sleepers.Head();
+	deadline = thread->alarmLink.key;
+	if (deadline > stats->totalTicks)
+	    break;
+	sleepers.Unlink(thread);
+	if (thread->getStatus() != BLOCKED)	// woken, but not run yet
+	    continue;
+	DEBUG('t', "Alarm of thread \"%s\" went off\n", thread->getName());
+	queue = ThreadQueue::ListOf(thread);
+	if (queue != NULL)
+	    queue->Unlink(thread);
+	thread->timedOut = TRUE;
+	scheduler->ReadyToRun(thread);
+    }
+    Arm();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Arm
+// 	Make sure an interrupt goes off by the earliest deadline.
+//----------------------------------------------------------------------
+
+void
+Alarm::Arm()
+{
+    int deadline;
+
+    if (sleepers.IsEmpty())
+	return;
+    deadline = sleepers.Head()->alarmLink.key;
+    if (nextInterrupt == -1 || deadline < nextInterrupt) {
+	interrupt->Schedule(AlarmHandler, deadline,
+	    deadline - stats->totalTicks, AlarmInt);
+	nextInterrupt = deadline;
+    }
+}
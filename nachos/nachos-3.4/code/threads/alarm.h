@@ -0,0 +1,54 @@
+// alarm.h
+//	Data structures for a kernel timer service: waking up threads
+//	that wait with a time limit.
+//
+//	A thread sets an alarm before it goes to sleep, and cancels it
+//	once it is woken.  If the alarm goes off first, the thread is taken
+//	off whatever queue it sleeps on and made ready, with its "timedOut"
+//	flag set.
+//
+//	The alarms are kept in a list sorted by deadline, linked through
+//	the threads themselves, so cancelling one takes constant time.  A
+//	single interrupt is kept scheduled for the earliest deadline.
+//	Interrupts cannot be taken back, so one may go off for an alarm
+//	that was cancelled since; it then just finds nothing to do.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "thread.h"
+
+// The following class defines the alarms of the kernel threads.  All
+// of its routines must be called with interrupts off.
+
+class Alarm {
+  public:
+    Alarm();				// Initialize, with no alarm set
+    ~Alarm();
+
+    void Set(Thread *thread, int ticks);
+					// Wake "thread" in "ticks" ticks,
+					// unless the alarm is cancelled
+    void Cancel(Thread *thread);	// Cancel the alarm of "thread", if
+					// it has not gone off
+
+    void Expire(int when);		// Interrupt handler: wake the threads
+					// whose deadline has passed
+
+  private:
+    void Arm();				// Schedule an interrupt for the
+					// earliest deadline, if needed
+
+    IntrusiveList<Thread, &Thread::alarmLink> sleepers;
+					// threads with an alarm set, by
+					// deadline
+    int nextInterrupt;			// when the earliest interrupt we
+					// scheduled goes off, -1 if none
+};
+
+#endif // ALARM_H
@@ -0,0 +1,541 @@
+// cpu.cc
+//	Routines to simulate the CPUs of a multiprocessor, and to share
+//	the host among them.
+//
+//	The thread running on a CPU that is not being simulated stays
+//	RUNNING, without being on any queue; when its CPU is simulated
+//	again, it carries on from where it was, like a thread switched
+//	back to by Scheduler::Run.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// IdleLoop
+// 	The body of the idle thread of a CPU: run whatever there is to
+//	run, and let time pass when there is nothing.
+//
+//	"which" is the number of the CPU
+//----------------------------------------------------------------------
+
+static void
+IdleLoop(int which)
+{
+    Thread *nextThread;
+
+    (void) interrupt->SetLevel(IntOff);
+    for (;;) {
+	ASSERT(smp->Running()->id == which);
+	nextThread = scheduler->FindNextToRun();
+	if (nextThread != currentThread) {
+	    currentThread->setStatus(READY);	// but on no queue
+	    scheduler->Run(nextThread);
+	} else
+	    smp->Idle();
+    }
+}
+
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// RunUser
+// 	Run the user program of CPU "which", on a host thread of its own,
+//	until its clock reaches its limit, or an instruction would trap.
+//	Nothing another CPU uses is touched: the CPU has registers and a
+//	TLB of its own, no other CPU is running its address space, and
+//	an instruction that would call the kernel, or store to a page
+//	that other address spaces map, is left undone.
+//----------------------------------------------------------------------
+
+static void
+RunUser(int which)
+{
+    Cpu *cpu = smp->GetCpu(which);
+    Machine *engine = cpu->engine;
+    Instruction instr;
+    int start = cpu->clock;
+
+    engine->trapped = FALSE;
+    while (cpu->clock < cpu->limit) {
+	engine->OneInstruction(&instr);
+	if (engine->trapped)
+	    break;
+	cpu->clock += UserTick;
+    }
+    cpu->parallelTicks += cpu->clock - start;
+}
+#endif
+
+//----------------------------------------------------------------------
+// Cpu::Cpu
+// 	Initialize a CPU, with nothing to run.  CPU 0 uses the TLB of the
+//	machine; the others get one of their own.
+//
+//	"number" is its number, from 0
+//----------------------------------------------------------------------
+
+Cpu::Cpu(int number)
+{
+    id = number;
+    current = NULL;
+    idleThread = NULL;
+    numReady = 0;
+    clock = stats->totalTicks;
+    idleTicks = switches = steals = 0;
+#ifdef USER_PROGRAM
+    tlb = machine->tlb;
+    if (tlb != NULL && id != 0) {
+	tlb = new TranslationEntry[TLBSize];
+	for (int i = 0; i < TLBSize; i++)
+	    tlb[i].valid = FALSE;
+    }
+    pageTable = NULL;
+    pageTableSize = 0;
+    space = NULL;
+    inUser = FALSE;
+    engine = NULL;
+    limit = parallelTicks = 0;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Cpu::~Cpu
+// 	De-allocate a CPU.  Its threads are not deleted.
+//----------------------------------------------------------------------
+
+Cpu::~Cpu()
+{
+#ifdef USER_PROGRAM
+    if (id != 0)
+	delete [] tlb;
+    delete engine;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Multiprocessor
+// 	Initialize the CPUs.  The thread running now runs on CPU 0, which
+//	is the one being simulated.
+//
+//	"n" is how many CPUs there are, at least 2
+//	"runParallel" is TRUE to run user programs in parallel on the
+//		host, if there are any
+//----------------------------------------------------------------------
+
+Multiprocessor::Multiprocessor(int n, bool runParallel)
+{
+    ASSERT(n > 1);
+    numCpus = n;
+    cpus = new Cpu *[n];
+    for (int i = 0; i < n; i++)
+	cpus[i] = new Cpu(i);
+    running = 0;
+    cpus[0]->current = currentThread;
+    currentThread->cpu = cpus[0];
+    quantum = CpuQuantum;
+#ifdef USER_PROGRAM
+    parallel = runParallel;
+    windowEnd = windows = 0;
+    batch = NULL;
+    if (parallel) {
+	quantum = ParallelQuantum;
+	batch = new int[n];
+	for (int i = 0; i < n; i++)
+	    cpus[i]->engine = new Machine(machine);
+    }
+#endif
+    quantumEnd = (stats->totalTicks / quantum + 1) * quantum;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::~Multiprocessor
+// 	De-allocate the CPUs, and give the machine back the TLB it was
+//	built with.
+//----------------------------------------------------------------------
+
+Multiprocessor::~Multiprocessor()
+{
+#ifdef USER_PROGRAM
+    machine->tlb = cpus[0]->tlb;
+    delete [] batch;
+#endif
+    for (int i = 0; i < numCpus; i++)
+	delete cpus[i];
+    delete [] cpus;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Start
+// 	Create the idle thread of each CPU.  An idle thread is never put
+//	on a ready queue; it runs when FindNextToRun finds nothing else.
+//	The other CPUs start out running theirs.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::Start()
+{
+    Thread *t;
+    char *name;
+
+    for (int i = 0; i < numCpus; i++) {
+	name = new char[16];
+	sprintf(name, "idle %d", i);
+	t = new Thread(name);
+	t->cpu = cpus[i];
+	cpus[i]->idleThread = t;
+	t->Fork(IdleLoop, i);
+	if (i != 0)
+	    cpus[i]->current = t;
+    }
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::ReadyToRun
+// 	Put a thread on the ready queue of the CPU it last ran on, or of
+//	the CPU being simulated, if it has not run yet.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::ReadyToRun(Thread *thread)
+{
+    if (thread->cpu == NULL)
+	thread->cpu = cpus[running];
+    if (thread == thread->cpu->idleThread)
+	return;
+    thread->cpu->readyList.Append(thread);
+    thread->cpu->numReady++;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::FindNextToRun
+// 	Return the next thread to run on the CPU being simulated: the most
+//	urgent of its ready threads, else one stolen from another CPU, else
+//	its idle thread.
+//----------------------------------------------------------------------
+
+Thread *
+Multiprocessor::FindNextToRun()
+{
+    Cpu *cpu = cpus[running];
+    Thread *thread = cpu->readyList.RemoveMin(ThreadPriority);
+
+    if (thread != NULL)
+	cpu->numReady--;
+    else
+	thread = Steal(cpu);
+    if (thread == NULL)
+	thread = cpu->idleThread;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Steal
+// 	Take the most urgent ready thread of the CPU with the most ready
+//	threads, to run it on "thief", which has none.
+//
+// Returns:
+//	The stolen thread, NULL if no other CPU has a ready thread.
+//----------------------------------------------------------------------
+
+Thread *
+Multiprocessor::Steal(Cpu *thief)
+{
+    Cpu *victim = NULL;
+    Thread *thread;
+
+    for (int i = 0; i < numCpus; i++)
+	if (cpus[i] != thief && cpus[i]->numReady > 0 &&
+		(victim == NULL || cpus[i]->numReady > victim->numReady))
+	    victim = cpus[i];
+    if (victim == NULL)
+	return NULL;
+    thread = victim->readyList.RemoveMin(ThreadPriority);
+    victim->numReady--;
+    thread->cpu = thief;
+    thief->steals++;
+    DEBUG('t', "CPU %d steals thread \"%s\" from CPU %d\n", thief->id,
+	thread->getName(), victim->id);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::AllIdle
+// 	Return TRUE if every CPU is running its idle thread.  Called when
+//	the CPU being simulated found nothing to run, nor to steal, so no
+//	thread is ready anywhere either.
+//----------------------------------------------------------------------
+
+bool
+Multiprocessor::AllIdle()
+{
+    for (int i = 0; i < numCpus; i++)
+	if (cpus[i]->current != cpus[i]->idleThread)
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Idle
+// 	The CPU being simulated has nothing to run.  If no CPU has, roll
+//	simulated time forward to the next interrupt, for all of them, as
+//	Interrupt::Idle does for one CPU.  Otherwise, this CPU sits idle
+//	until the next interrupt, or the end of its quantum, whichever
+//	comes first.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::Idle()
+{
+    Cpu *cpu = cpus[running];
+    int start = stats->totalTicks;
+    int i;
+
+    if (AllIdle()) {
+	interrupt->Idle();		// halts if there is nothing to wait for
+	for (i = 0; i < numCpus; i++)
+	    if (cpus[i] != cpu && cpus[i]->clock < stats->totalTicks) {
+		cpus[i]->idleTicks += stats->totalTicks - cpus[i]->clock;
+		cpus[i]->clock = stats->totalTicks;
+	    }
+	cpu->idleTicks += stats->totalTicks - start;
+	quantumEnd = (stats->totalTicks / quantum + 1) * quantum;
+    } else {
+	(void) interrupt->IdleUntil(quantumEnd);
+	cpu->idleTicks += stats->totalTicks - start;
+	if (stats->totalTicks >= quantumEnd)
+	    EndQuantum(FALSE);
+    }
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Behind
+// 	Return the number of the CPU whose clock is the furthest behind,
+//	the lowest numbered one among equals.
+//----------------------------------------------------------------------
+
+int
+Multiprocessor::Behind()
+{
+    int cpu = 0;
+
+    for (int i = 1; i < numCpus; i++)
+	if (cpus[i]->clock < cpus[cpu]->clock)
+	    cpu = i;
+    return cpu;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::EndQuantum
+// 	The CPU being simulated has reached the end of its quantum.  Let
+//	the CPU whose clock is the furthest behind run; if that is this
+//	one, it just carries on.  With -par, the CPUs may first run some
+//	more in parallel.
+//
+//	"userMode" is TRUE if this CPU is between two user instructions
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::EndQuantum(bool userMode)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int next;
+
+    cpus[running]->clock = stats->totalTicks;
+#ifdef USER_PROGRAM
+    cpus[running]->inUser = userMode;
+    if (parallel)
+	RunParallel();
+#endif
+    next = Behind();
+    if (next != running)
+	SwitchTo(next);			// returns when this CPU is next
+    else				// simulated
+	quantumEnd = (stats->totalTicks / quantum + 1) * quantum;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::SwitchTo
+// 	Hand the host over to CPU "next": save the user registers and the
+//	page table register of the CPU being simulated, load those of the
+//	next one, and switch to the thread running on it.  The thread we
+//	leave stays RUNNING on its CPU, and carries on when that CPU is
+//	simulated again.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::SwitchTo(int next)
+{
+    Cpu *from = cpus[running];
+    Cpu *to = cpus[next];
+    Thread *oldThread = currentThread;
+
+    ASSERT(interrupt->getLevel() == IntOff);
+#ifdef USER_PROGRAM
+    if (oldThread->space != NULL) {	// save the user state of the
+	oldThread->SaveUserState();	// CPU we leave
+	oldThread->space->SaveState();
+    }
+    from->pageTable = machine->pageTable;
+    from->pageTableSize = machine->pageTableSize;
+    machine->tlb = to->tlb;		// and switch to the MMU of the
+    machine->pageTable = to->pageTable;	// next one
+    machine->pageTableSize = to->pageTableSize;
+#endif
+    from->clock = stats->totalTicks;
+    running = next;
+    stats->totalTicks = to->clock;
+    quantumEnd = (to->clock / quantum + 1) * quantum;
+
+    DEBUG('t', "CPU %d at time %d hands over to CPU %d at time %d\n",
+	from->id, from->clock, to->id, to->clock);
+    scheduler->Switch(oldThread, to->current);
+}
+
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// Multiprocessor::RunParallel
+// 	If every CPU has been simulated to the end of the last parallel
+//	window, run the next one: the CPUs that are between two user
+//	instructions run in parallel to the end of the window, or until
+//	just before the next interrupt is due.  Repeat for as long as
+//	they all get to the end of the window that way; the CPUs that
+//	stopped early are left to be simulated one at a time.
+//
+//	The CPU being simulated takes part like the others, so its user
+//	registers and page table register are saved beforehand, and
+//	reloaded afterwards, with its clock.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::RunParallel()
+{
+    Cpu *cpu = cpus[running];
+    int limit, due;
+
+    if (cpus[Behind()]->clock < windowEnd)
+	return;				// some CPU is not done yet
+    if (cpu->inUser) {
+	currentThread->SaveUserState();
+	cpu->pageTable = machine->pageTable;
+	cpu->pageTableSize = machine->pageTableSize;
+    }
+    for (;;) {
+	windowEnd = (cpus[Behind()]->clock / quantum + 1) * quantum;
+	limit = windowEnd;
+	due = interrupt->NextPending();
+	if (due != -1 && due - UserTick < limit)
+	    limit = due - UserTick;	// leave the tick that takes it
+	if (RunWindow(limit) == 0 || cpus[Behind()]->clock < windowEnd)
+	    break;
+    }
+    stats->totalTicks = cpu->clock;
+    if (cpu->inUser)
+	currentThread->RestoreUserState();
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::RunWindow
+// 	Run the user programs of the CPUs that are between two user
+//	instructions in parallel, until their clocks reach "limit", or
+//	an instruction would trap.  Of several CPUs running the same
+//	address space, only the first one runs, since the others would
+//	see its stores.
+//
+// Returns:
+//	The number of CPUs that ran.
+//----------------------------------------------------------------------
+
+int
+Multiprocessor::RunWindow(int limit)
+{
+    Cpu *cpu;
+    int count = 0, ran = 0;
+    int i, j;
+
+    for (i = 0; i < numCpus; i++) {
+	cpu = cpus[i];
+	if (!cpu->inUser || cpu->clock >= limit)
+	    continue;
+	for (j = 0; j < count; j++)
+	    if (cpus[batch[j]]->current->space == cpu->current->space)
+		break;
+	if (j < count)
+	    continue;
+	cpu->current->RestoreUserState(cpu->engine);
+	cpu->engine->tlb = cpu->tlb;
+	cpu->engine->pageTable = cpu->pageTable;
+	cpu->engine->pageTableSize = cpu->pageTableSize;
+	cpu->limit = limit;
+	ran -= cpu->parallelTicks;
+	batch[count++] = i;
+    }
+    if (count == 0)
+	return 0;
+
+    DEBUG('t', "%d CPUs run in parallel until time %d\n", count, limit);
+    RunInParallel(RunUser, batch, count);
+
+    for (j = 0; j < count; j++) {
+	cpu = cpus[batch[j]];
+	cpu->current->SaveUserState(cpu->engine);
+	ran += cpu->parallelTicks;
+	machine->TLBhit += cpu->engine->TLBhit;
+	machine->TLBmiss += cpu->engine->TLBmiss;
+	cpu->engine->TLBhit = cpu->engine->TLBmiss = 0;
+    }
+    stats->userTicks += ran;
+    windows++;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Forget
+// 	An address space is being deleted: no CPU holds its translations
+//	any more.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::Forget(AddrSpace *space)
+{
+    for (int i = 0; i < numCpus; i++)
+	if (cpus[i]->space == space) {
+	    cpus[i]->space = NULL;
+	    cpus[i]->pageTable = NULL;
+	    cpus[i]->pageTableSize = 0;
+	}
+}
+#endif
+
+//----------------------------------------------------------------------
+// Multiprocessor::Print
+// 	Print what each CPU did, when Nachos halts.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::Print()
+{
+    Cpu *cpu;
+    int elapsed;
+
+    printf("CPUs: %d, quantum %d ticks\n", numCpus, quantum);
+    for (int i = 0; i < numCpus; i++) {
+	cpu = cpus[i];
+	elapsed = (i == running) ? stats->totalTicks : cpu->clock;
+	printf("CPU %d: busy %d ticks, idle %d, context switches %d, "
+	    "steals %d\n", i, elapsed - cpu->idleTicks, cpu->idleTicks,
+	    cpu->switches, cpu->steals);
+    }
+#ifdef USER_PROGRAM
+    if (parallel) {
+	printf("Parallel windows: %d, user ticks run in parallel:", windows);
+	for (int i = 0; i < numCpus; i++)
+	    printf(" %d", cpus[i]->parallelTicks);
+	printf("\n");
+    }
+#endif
+}
@@ -0,0 +1,152 @@
+// cpu.h
+//	Data structures to simulate a shared-memory multiprocessor.
+//
+//	With -smp, Nachos simulates several CPUs instead of one.  Each CPU
+//	has the thread running on it, a queue of threads ready to run on
+//	it, and an idle thread, which runs when there is nothing else.  A
+//	thread is made ready on the CPU it last ran on; a CPU with nothing
+//	to run steals a thread from the CPU with the most ready threads.
+//	For user programs, each CPU also has its own TLB and page table
+//	register; the user registers of a CPU are those of its thread.
+//
+//	The CPUs are simulated one at a time, on the one host thread, each
+//	with a clock of its own.  A CPU runs until its clock reaches the end
+//	of a quantum; then the CPU whose clock is the furthest behind (the
+//	lowest numbered, among equals) takes over, so the CPUs run the same
+//	stretch of simulated time in turn, and never drift more than a
+//	quantum apart.  "stats->totalTicks" is the clock of the CPU being
+//	simulated, and an interrupt is taken by the first CPU whose clock
+//	reaches it.
+//
+//	Since the CPUs only change hands on clock ticks, code running with
+//	interrupts disabled is atomic across all of them, as it is on one
+//	CPU.  Data used across clock ticks by threads on different CPUs is
+//	protected with a SpinLock (see synch.h).
+//
+//	With -par, the CPUs running user programs are also simulated in
+//	parallel, on host threads of their own, in lock-step windows of
+//	ParallelQuantum ticks.  Once every CPU has reached the end of a
+//	window, each CPU that was left between two user instructions runs
+//	on, until the end of the next window, until just before the next
+//	interrupt is due, or until an instruction would trap to the
+//	kernel, or store to a page other address spaces map.  That
+//	instruction is left undone; the CPUs that stopped early are then
+//	simulated one at a time, as usual, up to the end of the window.
+//	So the kernel still runs on one host thread, and a CPU running in
+//	parallel never touches what another one uses: only the first of
+//	several CPUs running the same address space runs in parallel.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "thread.h"
+
+#define CpuQuantum	100	// ticks a CPU runs before the next one
+				// catches up
+#define ParallelQuantum	1000	// the same, with -par: long enough for
+				// the host threads to make up for the
+				// time they take to start and stop
+
+// The following class defines one simulated CPU.
+
+class Cpu {
+  public:
+    Cpu(int number);			// Initialize a CPU, with nothing
+					// to run
+    ~Cpu();
+
+    int id;				// its number, from 0
+    Thread *current;			// the thread running on it
+    Thread *idleThread;			// runs when nothing else can
+    ThreadQueue readyList;		// threads ready to run on it
+    int numReady;			// how many there are
+    int clock;				// its time, while another CPU is
+					// being simulated
+
+    int idleTicks;			// time spent with nothing to run
+    int switches;			// context switches
+    int steals;				// threads taken from other CPUs
+
+#ifdef USER_PROGRAM
+    TranslationEntry *tlb;		// its TLB, NULL if the machine
+					// has none
+    PageTable *pageTable;		// its page table register, while
+    unsigned int pageTableSize;		// another CPU is being simulated
+    AddrSpace *space;			// the address space whose
+					// translations are loaded
+
+    bool inUser;			// its thread was left between two
+					// user instructions
+    Machine *engine;			// runs them in parallel with the
+					// other CPUs, with -par
+    int limit;				// the time to run them until
+    int parallelTicks;			// time spent running them so
+#endif
+};
+
+// The following class defines the CPUs of the machine, and how they
+// share the host.  All of its routines must be called with interrupts
+// off, except Start.
+
+class Multiprocessor {
+  public:
+    Multiprocessor(int n, bool runParallel);
+					// Initialize "n" CPUs; the thread
+					// running now runs on the first
+    ~Multiprocessor();
+
+    void Start();			// Create the idle threads
+
+    Cpu *Running() { return cpus[running]; }
+					// The CPU being simulated
+    int NumCpus() { return numCpus; }
+    Cpu *GetCpu(int i) { return cpus[i]; }
+
+    void ReadyToRun(Thread *thread);	// Queue "thread" on its CPU
+    Thread *FindNextToRun();		// The next thread for the CPU
+					// being simulated, never NULL
+
+    void Idle();			// The CPU being simulated has
+					// nothing to run: let time pass
+    int QuantumEnd() { return quantumEnd; }
+    void EndQuantum(bool userMode);	// Let the CPU the furthest behind
+					// run
+
+#ifdef USER_PROGRAM
+    void Forget(AddrSpace *space);	// "space" is being deleted
+#endif
+
+    void Print();			// Print what each CPU did
+
+  private:
+    Thread *Steal(Cpu *thief);		// Take a ready thread from the
+					// busiest other CPU
+    bool AllIdle();			// Is every CPU idle?
+    int Behind();			// The CPU the furthest behind
+    void SwitchTo(int next);		// Simulate CPU "next" from now on
+
+    Cpu **cpus;				// the CPUs
+    int numCpus;
+    int running;			// the one being simulated
+    int quantum;			// how long each runs in turn
+    int quantumEnd;			// when it lets another one run
+
+#ifdef USER_PROGRAM
+    void RunParallel();			// Run the CPUs in parallel, if
+					// they are all done with a window
+    int RunWindow(int limit);		// Run those that can be, until
+					// "limit"
+
+    bool parallel;			// run user programs in parallel?
+    int windowEnd;			// end of the last parallel window
+    int windows;			// how many were run
+    int *batch;				// CPUs running in the current one
+#endif
+};
+
+#endif // CPU_H
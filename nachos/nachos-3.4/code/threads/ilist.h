@@ -0,0 +1,277 @@
+// ilist.h
+//	Data structures to manage "intrusive" lists: doubly-linked lists
+//	whose links are kept inside the items themselves, rather than in
+//	a ListElement allocated for each item.
+//
+//	Putting an item on an intrusive list, or taking it off, never
+//	allocates or frees memory, which matters on paths taken at every
+//	context switch and every interrupt: the ready list, the queues of
+//	threads waiting on a synchronization object, and the pending
+//	interrupts.  And since an item knows where it is linked, it can be
+//	taken off the middle of a list in constant time; for instance, a
+//	thread can be removed from the queue it sleeps on.
+//
+//	The price is that an item can be on only as many lists at once as
+//	it has links.  A Thread has a single one, "queueLink", because a
+//	thread waits in at most one queue at a time: the ready list, or
+//	the queue of whatever it is blocked on.
+//
+// 	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ILIST_H
+#define ILIST_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines the links embedded in an item of type T,
+// to keep track of its place on a list.
+
+template <class T>
+class ListLink {
+  public:
+    ListLink() { next = prev = NULL; key = 0; list = NULL; }
+
+    T *next;			// next item on the list, NULL if last
+    T *prev;			// previous item, NULL if first
+    int key;			// priority, for a sorted list
+    void *list;			// the list the item is on, NULL if none
+};
+
+// The following class defines an intrusive list of items of type T,
+// linked through their member "Link".  Like a List, it can be kept
+// sorted in increasing order of "key", with the Sorted functions.
+//
+// The items are not de-allocated with the list.
+
+template <class T, ListLink<T> T::*Link>
+class IntrusiveList {
+  public:
+    IntrusiveList() { first = last = NULL; }	// initialize the list
+
+    bool IsEmpty() { return first == NULL; }	// is the list empty?
+    bool Contains(T *item) { return (item->*Link).list == this; }
+					// is "item" on this list?
+    static IntrusiveList *ListOf(T *item)
+	{ return (IntrusiveList *) (item->*Link).list; }
+					// the list "item" is on, NULL if
+					// none
+    T *Head() { return first; }		// first item, NULL if empty
+    T *Next(T *item) { return (item->*Link).next; }
+					// item after "item", NULL if last
+
+    void Append(T *item);		// Put item at the end of the list
+    void Prepend(T *item);		// Put item at the beginning
+    T *Remove();			// Take item off the front of the list
+    void Unlink(T *item);		// Take "item" off the list, wherever
+					// it is
+
+    void Mapcar(void (*func)(T *));	// Apply "func" to every item
+
+    // Routines to put/get items on/off list in order (sorted by key)
+    void SortedInsert(T *item, int sortKey);	// Put item into list
+    T *SortedRemove(int *keyPtr);		// Remove first item
+
+    T *RemoveMin(int (*keyOf)(T *));	// Remove the item for which
+					// "keyOf" is smallest; the first
+					// one, among equals
+
+  private:
+    T *first;				// Head of the list, NULL if empty
+    T *last;				// Last item on the list
+};
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Append
+//      Append an "item" to the end of the list.  The item must not be
+//	on any list.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+inline void
+IntrusiveList<T, Link>::Append(T *item)
+{
+    ListLink<T> *link = &(item->*Link);
+
+    ASSERT(link->list == NULL);
+    link->list = this;
+    link->next = NULL;
+    link->prev = last;
+    if (last == NULL)			// list is empty
+	first = item;
+    else
+	(last->*Link).next = item;
+    last = item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Prepend
+//      Put an "item" on the front of the list.  The item must not be
+//	on any list.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+inline void
+IntrusiveList<T, Link>::Prepend(T *item)
+{
+    ListLink<T> *link = &(item->*Link);
+
+    ASSERT(link->list == NULL);
+    link->list = this;
+    link->prev = NULL;
+    link->next = first;
+    if (first == NULL)			// list is empty
+	last = item;
+    else
+	(first->*Link).prev = item;
+    first = item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Unlink
+//      Take an item off the list, wherever it is on it.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+inline void
+IntrusiveList<T, Link>::Unlink(T *item)
+{
+    ListLink<T> *link = &(item->*Link);
+
+    ASSERT(link->list == this);
+    if (link->prev == NULL)
+	first = link->next;
+    else
+	(link->prev->*Link).next = link->next;
+    if (link->next == NULL)
+	last = link->prev;
+    else
+	(link->next->*Link).prev = link->prev;
+    link->next = link->prev = NULL;
+    link->list = NULL;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Remove
+//      Remove the first item from the front of the list.
+//
+// Returns:
+//	Pointer to removed item, NULL if nothing on the list.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+inline T *
+IntrusiveList<T, Link>::Remove()
+{
+    T *item = first;
+
+    if (item != NULL)
+	Unlink(item);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Mapcar
+//	Apply a function to each item on the list.  The function must
+//	not take the item off the list.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void
+IntrusiveList<T, Link>::Mapcar(void (*func)(T *))
+{
+    for (T *item = first; item != NULL; item = (item->*Link).next)
+	(*func)(item);
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::SortedInsert
+//      Insert an "item" into a list, so that the items are sorted in
+//	increasing order by "sortKey"; after any items with the same key.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void
+IntrusiveList<T, Link>::SortedInsert(T *item, int sortKey)
+{
+    ListLink<T> *link = &(item->*Link);
+    T *ptr;
+
+    // look for the last item not bigger than this one, from the end:
+    // new items tend to go there
+    for (ptr = last; ptr != NULL && sortKey < (ptr->*Link).key;
+	    ptr = (ptr->*Link).prev)
+	;
+    if (ptr == NULL) {			// item goes on front of list
+	Prepend(item);
+    } else {
+	ASSERT(link->list == NULL);
+	link->list = this;
+	link->prev = ptr;
+	link->next = (ptr->*Link).next;
+	if (link->next == NULL)
+	    last = item;
+	else
+	    (link->next->*Link).prev = item;
+	(ptr->*Link).next = item;
+    }
+    link->key = sortKey;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::SortedRemove
+//      Remove the first item from the front of a sorted list.
+//
+// Returns:
+//	Pointer to removed item, NULL if nothing on the list.
+//	Sets *keyPtr to the priority value of the removed item.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+inline T *
+IntrusiveList<T, Link>::SortedRemove(int *keyPtr)
+{
+    T *item = Remove();
+
+    if (item != NULL && keyPtr != NULL)
+	*keyPtr = (item->*Link).key;
+    return item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::RemoveMin
+//      Remove the item with the smallest key, where the key is computed
+//	when we look: for queues of threads whose priorities change while
+//	they wait.  Among items with the same key, the first one is
+//	removed, so a list whose items all have the same key is a FIFO.
+//
+// Returns:
+//	Pointer to removed item, NULL if nothing on the list.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+T *
+IntrusiveList<T, Link>::RemoveMin(int (*keyOf)(T *))
+{
+    T *item, *min = first;
+    int key, minKey;
+
+    if (min == NULL)
+	return NULL;
+    minKey = (*keyOf)(min);
+    for (item = (min->*Link).next; item != NULL; item = (item->*Link).next) {
+	key = (*keyOf)(item);
+	if (key < minKey) {
+	    min = item;
+	    minKey = key;
+	}
+    }
+    Unlink(min);
+    return min;
+}
+
+#endif // ILIST_H
@@ -1,13 +1,27 @@
-// list.h 
-//	Data structures to manage LISP-like lists.  
+// list.h
+//	Data structures to manage LISP-like lists.
 //
 //      As in LISP, a list can contain any type of data structure
-//	as an item on the list: thread control blocks, 
-//	pending interrupts, etc.  That is why each item is a "void *",
-//	or in other words, a "pointers to anything".
+//	as an item on the list: message buffers, file handles, etc.
+//	The lists are templates, parameterized by the type of the items,
+//	so that what comes off a list needs no cast back to what was
+//	put on it.
+//
+//	A "ListElement" is allocated for each item put on a list, and
+//	de-allocated when the item is removed, so the items need not
+//	have a "next" pointer of their own.  Lists on the paths taken at
+//	every context switch and interrupt (the ready list, wait queues,
+//	pending interrupts) link their items directly instead; see ilist.h.
+//
+//	All the routines are defined here, so that the compiler can
+//	inline them.
+//
+// 	NOTE: Mutual exclusion must be provided by the caller.
+//  	If you want a synchronized list, you must use the routines
+//	in synchlist.h.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
-// All rights reserved.  See copyright.h for copyright notice and limitation 
+// All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
 
 #ifndef LIST_H
@@ -19,50 +33,296 @@
 // The following class defines a "list element" -- which is
 // used to keep track of one item on a list.  It is equivalent to a
 // LISP cell, with a "car" ("next") pointing to the next element on the list,
-// and a "cdr" ("item") pointing to the item on the list.
+// and a "cdr" ("item") holding the item on the list.
 //
 // Internal data structures kept public so that List operations can
 // access them directly.
 
+template <class T>
 class ListElement {
    public:
-     ListElement(void *itemPtr, int sortKey);	// initialize a list element
+     ListElement(T theItem) { item = theItem; next = NULL; }
+				// initialize a list element
 
-     ListElement *next;		// next element on list, 
+     ListElement *next;		// next element on list,
 				// NULL if this is the last
-     int key;		    	// priority, for a sorted list
-     void *item; 	    	// pointer to item on the list
+     T item; 	    		// the item on the list
 };
 
 // The following class defines a "list" -- a singly linked list of
-// list elements, each of which points to a single item on the list.
-//
-// By using the "Sorted" functions, the list can be kept in sorted
-// in increasing order by "key" in ListElement.
+// list elements, each of which holds a single item of type T.
 
+template <class T>
 class List {
   public:
-    List();			// initialize the list
-    ~List();			// de-allocate the list
+    List() { first = last = NULL; }	// initialize the list
+    ~List();				// de-allocate the list
 
-    void Prepend(void *item); 	// Put item at the beginning of the list
-    void Append(void *item); 	// Put item at the end of the list
-    void *Remove(); 	 	// Take item off the front of the list
+    void Prepend(T item); 	// Put item at the beginning of the list
+    void Append(T item); 	// Put item at the end of the list
+    T Remove(); 	 	// Take item off the front of the list;
+				// T() (NULL, for pointers) if empty
+    T Head() { ASSERT(first != NULL); return first->item; }
+				// First item, without removing it
 
-    void Mapcar(VoidFunctionPtr func);	// Apply "func" to every element 
+    void Mapcar(void (*func)(T));	// Apply "func" to every item
 					// on the list
-    bool IsEmpty();		// is the list empty? 
-    
+    bool IsEmpty() { return first == NULL; }	// is the list empty?
+
+  private:
+    ListElement<T> *first;  	// Head of the list, NULL if list is empty
+    ListElement<T> *last;	// Last element of list
+};
+
+// The following class defines a list kept sorted in increasing order
+// of a key of type Key, which must have a "<" operator.  Items with
+// equal keys come off in the order they were put on.
+
+template <class T, class Key>
+class SortedListElement {
+   public:
+     SortedListElement(T theItem, Key sortKey)
+	{ item = theItem; key = sortKey; next = NULL; }
 
-    // Routines to put/get items on/off list in order (sorted by key)
-    void SortedInsert(void *item, int sortKey);	// Put item into list
-    void *SortedRemove(int *keyPtr); 	  	// Remove first item from list
+     SortedListElement *next;	// next element on list, NULL if last
+     Key key;			// priority, for a sorted list
+     T item;			// the item on the list
+};
 
-    void *Head(int *keyPtr);
+template <class T, class Key>
+class SortedList {
+  public:
+    SortedList() { first = last = NULL; }	// initialize the list
+    ~SortedList();				// de-allocate the list
+
+    void Insert(T item, Key sortKey);	// Put item into the list
+    T Remove(Key *keyPtr);		// Remove the first item, setting
+					// *keyPtr (if not NULL) to its key;
+					// T() if the list is empty
+    T Head(Key *keyPtr);		// First item, without removing it
+
+    void Mapcar(void (*func)(T));	// Apply "func" to every item
+    bool IsEmpty() { return first == NULL; }
 
   private:
-    ListElement *first;  	// Head of the list, NULL if list is empty
-    ListElement *last;		// Last element of list
+    SortedListElement<T, Key> *first;	// Head of the list, NULL if empty
+    SortedListElement<T, Key> *last;	// Last element of list
 };
 
+//----------------------------------------------------------------------
+// List<T>::~List
+//	Prepare a list for deallocation.  If the list still contains any
+//	ListElements, de-allocate them.  However, note that we do *not*
+//	de-allocate the "items" on the list -- this module allocates
+//	and de-allocates the ListElements to keep track of each item,
+//	but a given item may be on multiple lists, so we can't
+//	de-allocate them here.
+//----------------------------------------------------------------------
+
+template <class T>
+List<T>::~List()
+{
+    while (!IsEmpty())
+	(void) Remove();	 // delete all the list elements
+}
+
+//----------------------------------------------------------------------
+// List<T>::Append
+//      Append an "item" to the end of the list.
+//
+//	Allocate a ListElement to keep track of the item.
+//      If the list is empty, then this will be the only element.
+//	Otherwise, put it at the end.
+//----------------------------------------------------------------------
+
+template <class T>
+inline void
+List<T>::Append(T item)
+{
+    ListElement<T> *element = new ListElement<T>(item);
+
+    if (IsEmpty()) {		// list is empty
+	first = element;
+	last = element;
+    } else {			// else put it after last
+	last->next = element;
+	last = element;
+    }
+}
+
+//----------------------------------------------------------------------
+// List<T>::Prepend
+//      Put an "item" on the front of the list.
+//
+//	Allocate a ListElement to keep track of the item.
+//      If the list is empty, then this will be the only element.
+//	Otherwise, put it at the beginning.
+//----------------------------------------------------------------------
+
+template <class T>
+inline void
+List<T>::Prepend(T item)
+{
+    ListElement<T> *element = new ListElement<T>(item);
+
+    if (IsEmpty()) {		// list is empty
+	first = element;
+	last = element;
+    } else {			// else put it before first
+	element->next = first;
+	first = element;
+    }
+}
+
+//----------------------------------------------------------------------
+// List<T>::Remove
+//      Remove the first "item" from the front of the list.
+//
+// Returns:
+//	The removed item; T(), which is NULL for a list of pointers, if
+//	the list is empty.
+//----------------------------------------------------------------------
+
+template <class T>
+inline T
+List<T>::Remove()
+{
+    ListElement<T> *element = first;
+    T thing;
+
+    if (IsEmpty())
+	return T();
+    thing = element->item;
+    first = element->next;
+    if (first == NULL)		// list had one item, now has none
+	last = NULL;
+    delete element;
+    return thing;
+}
+
+//----------------------------------------------------------------------
+// List<T>::Mapcar
+//	Apply a function to each item on the list, by walking through
+//	the list, one element at a time.
+//
+//	Unlike LISP, this mapcar does not return anything!
+//
+//	"func" is the procedure to apply to each element of the list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+List<T>::Mapcar(void (*func)(T))
+{
+    for (ListElement<T> *ptr = first; ptr != NULL; ptr = ptr->next)
+	(*func)(ptr->item);
+}
+
+//----------------------------------------------------------------------
+// SortedList<T, Key>::~SortedList
+//	Prepare a list for deallocation, de-allocating its elements, but
+//	not the items on it.
+//----------------------------------------------------------------------
+
+template <class T, class Key>
+SortedList<T, Key>::~SortedList()
+{
+    while (!IsEmpty())
+	(void) Remove(NULL);
+}
+
+//----------------------------------------------------------------------
+// SortedList<T, Key>::Insert
+//      Insert an "item" into a list, so that the list elements are
+//	sorted in increasing order by "sortKey", after any items with
+//	the same key.
+//
+//	Allocate a ListElement to keep track of the item.  Items put on
+//	in order go straight to the end of the list, without a search.
+//----------------------------------------------------------------------
+
+template <class T, class Key>
+inline void
+SortedList<T, Key>::Insert(T item, Key sortKey)
+{
+    SortedListElement<T, Key> *element =
+			new SortedListElement<T, Key>(item, sortKey);
+    SortedListElement<T, Key> *ptr;
+
+    if (IsEmpty()) {			// if list is empty, put
+	first = element;
+	last = element;
+    } else if (!(sortKey < last->key)) {	// item goes at end of list
+	last->next = element;
+	last = element;
+    } else if (sortKey < first->key) {	// item goes on front of list
+	element->next = first;
+	first = element;
+    } else {		// look for first elt in list bigger than item
+	for (ptr = first; !(sortKey < ptr->next->key); ptr = ptr->next)
+	    ;
+	element->next = ptr->next;
+	ptr->next = element;
+    }
+}
+
+//----------------------------------------------------------------------
+// SortedList<T, Key>::Remove
+//      Remove the first "item" from the front of a sorted list.
+//
+// Returns:
+//	The removed item; T(), which is NULL for a list of pointers, if
+//	the list is empty.  Sets *keyPtr to its key, if keyPtr is not
+//	NULL and there is an item (this is needed by interrupt.cc, for
+//	instance).
+//----------------------------------------------------------------------
+
+template <class T, class Key>
+inline T
+SortedList<T, Key>::Remove(Key *keyPtr)
+{
+    SortedListElement<T, Key> *element = first;
+    T thing;
+
+    if (IsEmpty())
+	return T();
+    thing = element->item;
+    if (keyPtr != NULL)
+	*keyPtr = element->key;
+    first = element->next;
+    if (first == NULL)
+	last = NULL;
+    delete element;
+    return thing;
+}
+
+//----------------------------------------------------------------------
+// SortedList<T, Key>::Head
+//      Return the first item of a sorted list, which must not be empty,
+//	leaving it on the list.  Sets *keyPtr to its key, if not NULL.
+//----------------------------------------------------------------------
+
+template <class T, class Key>
+inline T
+SortedList<T, Key>::Head(Key *keyPtr)
+{
+    ASSERT(!IsEmpty());
+    if (keyPtr != NULL)
+	*keyPtr = first->key;
+    return first->item;
+}
+
+//----------------------------------------------------------------------
+// SortedList<T, Key>::Mapcar
+//	Apply a function to each item on the list, in order.
+//----------------------------------------------------------------------
+
+template <class T, class Key>
+void
+SortedList<T, Key>::Mapcar(void (*func)(T))
+{
+    for (SortedListElement<T, Key> *ptr = first; ptr != NULL; ptr = ptr->next)
+	(*func)(ptr->item);
+}
+
 #endif // LIST_H
@@ -0,0 +1,266 @@
+// mailbox.cc 
+//	Routines for passing messages between threads.
+//
+//	Implemented in "monitor"-style, like the synchronized list: each
+//	procedure holds the mailbox lock, and waits on a condition for
+//	room or for a message.
+//
+//	A receive with a time limit waits on the condition with
+//	Condition::WaitFor, which sets an alarm for the deadline.
+//
+//	Closing and de-allocating need no lock against new senders: a
+//	sender only gets hold of a mailbox, and counts itself in
+//	"senders", between two points where it could lose the CPU.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "mailbox.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Mailbox::Mailbox
+//	Initialize an empty mailbox.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Mailbox::Mailbox(char *debugName)
+{
+    name = debugName;
+    head = used = 0;
+    closed = abandoned = FALSE;
+    senders = 0;
+    lock = new Lock("mailbox lock");
+    notEmpty = new Condition("mailbox not empty");
+    notFull = new Condition("mailbox not full");
+}
+
+//----------------------------------------------------------------------
+// Mailbox::~Mailbox
+//	De-allocate a mailbox.  Messages still in it are lost.
+//----------------------------------------------------------------------
+
+Mailbox::~Mailbox()
+{
+    delete notFull;
+    delete notEmpty;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// Mailbox::Send
+//	Append a message to the mailbox, waiting until there is room for
+//	it, and wake up the receiver.  Returns FALSE if the mailbox was
+//	closed first.
+//
+//	"data" is the message
+//	"size" is its length in bytes
+//----------------------------------------------------------------------
+
+bool
+Mailbox::Send(char *data, int size)
+{
+    return SendMany(&data, &size, 1);
+}
+
+//----------------------------------------------------------------------
+// Mailbox::SendMany
+//	Append several messages to the mailbox, in order.  The receiver
+//	is woken once, after the last one, unless the mailbox fills up
+//	first, in which case it is woken to make room.  Returns FALSE if
+//	the mailbox is closed before all of them are in; the ones sent
+//	are lost with it.
+//
+//	The last sender out of an abandoned mailbox de-allocates it.
+//
+//	"data", "sizes" are the messages, and their lengths
+//	"count" is the number of messages
+//----------------------------------------------------------------------
+
+bool
+Mailbox::SendMany(char **data, int *sizes, int count)
+{
+    int length, i;
+
+    senders++;
+    lock->Acquire();
+    for (i = 0; i < count; i++) {
+	ASSERT(sizes[i] >= 0 && sizes[i] <= MaxMessageSize);
+	while (!closed && MailboxSize - used < (int) sizeof(int) + sizes[i]) {
+	    notEmpty->Broadcast(lock);
+	    notFull->Wait(lock);
+	}
+	if (closed)
+	    break;
+	length = sizes[i];
+	Put((char *) &length, sizeof(int));
+	Put(data[i], sizes[i]);
+    }
+    DEBUG('t', "Sent %d messages to \"%s\"\n", i, name);
+    notEmpty->Broadcast(lock);
+    lock->Release();
+    if (--senders == 0 && abandoned)
+	delete this;
+    return i == count;
+}
+
+//----------------------------------------------------------------------
+// Mailbox::Receive
+//	Take the oldest message out of the mailbox, waiting for one if it
+//	is empty.  Returns the length of the message, or -1 if none came
+//	within the time limit.
+//
+//	"into", "size" are where to put the message, and how much room
+//	there is
+//	"timeout" is the longest time to wait, in ticks; -1 for ever
+//----------------------------------------------------------------------
+
+int
+Mailbox::Receive(char *into, int size, int timeout)
+{
+    int length = -1;
+
+    lock->Acquire();
+    if (WaitForMessage(timeout)) {
+	length = Take(into, size);
+	notFull->Broadcast(lock);
+    }
+    lock->Release();
+    return length;
+}
+
+//----------------------------------------------------------------------
+// Mailbox::ReceiveMany
+//	Take as many messages as there are, up to "max", out of the
+//	mailbox, waiting until there is at least one.  Returns the
+//	number of messages received, 0 if none came within the time
+//	limit.
+//
+//	"buffers" are where to put the messages
+//	"sizes" gives the room in each buffer, and is set to the length of
+//	each message received
+//	"timeout" is the longest time to wait, in ticks; -1 for ever
+//----------------------------------------------------------------------
+
+int
+Mailbox::ReceiveMany(char **buffers, int *sizes, int max, int timeout)
+{
+    int count = 0;
+
+    lock->Acquire();
+    if (WaitForMessage(timeout)) {
+	while (used > 0 && count < max) {
+	    sizes[count] = Take(buffers[count], sizes[count]);
+	    count++;
+	}
+	notFull->Broadcast(lock);
+    }
+    lock->Release();
+    DEBUG('t', "Received %d messages from \"%s\"\n", count, name);
+    return count;
+}
+
+//----------------------------------------------------------------------
+// Mailbox::Close
+//	Called by the receiver as it finishes.  Wake up the senders
+//	waiting for room, and make them, and any later sender, give up.
+//----------------------------------------------------------------------
+
+void
+Mailbox::Close()
+{
+    lock->Acquire();
+    closed = TRUE;
+    notFull->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Mailbox::Abandon
+//	Called when the receiver is de-allocated.  De-allocate the
+//	mailbox now if no sender is using it; otherwise the last one
+//	does, on its way out.
+//----------------------------------------------------------------------
+
+void
+Mailbox::Abandon()
+{
+    if (senders == 0)
+	delete this;
+    else
+	abandoned = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Mailbox::WaitForMessage
+//	Wait until the mailbox holds a message, or the time limit is
+//	up.  Returns TRUE if there is a message.  The caller must hold
+//	the lock.
+//
+//	"timeout" is the longest time to wait, in ticks; -1 for ever
+//----------------------------------------------------------------------
+
+bool
+Mailbox::WaitForMessage(int timeout)
+{
+    int deadline = stats->totalTicks + timeout;
+
+    while (used == 0) {
+	if (timeout < 0)
+	    notEmpty->Wait(lock);
+	else if (!notEmpty->WaitFor(lock, deadline - stats->totalTicks))
+	    break;			// out of time
+    }
+    return used > 0;
+}
+
+//----------------------------------------------------------------------
+// Mailbox::Put, Mailbox::Get
+//	Copy bytes into the free end of the ring buffer, or out of the
+//	full end, in up to two pieces around the end of the buffer.
+//----------------------------------------------------------------------
+
+void
+Mailbox::Put(char *data, int size)
+{
+    int tail = (head + used) % MailboxSize;
+    int piece = min(size, MailboxSize - tail);
+
+    bcopy(data, &buffer[tail], piece);
+    bcopy(data + piece, buffer, size - piece);
+    used += size;
+}
+
+void
+Mailbox::Get(char *data, int size)
+{
+    int piece = min(size, MailboxSize - head);
+
+    if (data != NULL) {
+	bcopy(&buffer[head], data, piece);
+	bcopy(buffer, data + piece, size - piece);
+    }
+    head = (head + size) % MailboxSize;
+    used -= size;
+}
+
+//----------------------------------------------------------------------
+// Mailbox::Take
+//	Remove the oldest message, copying as much of it as fits into a
+//	buffer.  Returns its length.
+//----------------------------------------------------------------------
+
+int
+Mailbox::Take(char *data, int size)
+{
+    int length;
+
+    Get((char *) &length, sizeof(int));
+    Get(data, min(length, size));
+    if (length > size)
+	Get(NULL, length - size);	// the rest does not fit
+    return length;
+}
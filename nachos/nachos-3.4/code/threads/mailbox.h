@@ -0,0 +1,86 @@
+// mailbox.h 
+//	Data structures for passing messages between kernel threads.
+//
+//	Every thread has a mailbox; other threads send it messages,
+//	and it receives them in the order they were sent.  A message
+//	is any string of bytes, up to MaxMessageSize long.
+//
+//	Messages are copied into a ring buffer inside the mailbox, each
+//	one prefixed with its length.  A sender waits while there is no
+//	room for its message; a receiver waits while the mailbox is
+//	empty, for ever or until a time limit.  Several messages can be
+//	sent or received at once, for the price of one lock acquisition
+//	and one wake-up.
+//
+//	When its thread finishes, the mailbox is closed: senders waiting
+//	for room give up, and so does any later send.  Since they still
+//	use the mailbox on their way out, it is only de-allocated once the
+//	last of them is gone.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include "copyright.h"
+#include "synch.h"
+
+#define MailboxSize	1024	// bytes of messages a mailbox can hold,
+				// counting their length prefixes
+#define MaxMessageSize	(MailboxSize - (int) sizeof(int))
+
+// The following class defines a mailbox.  "timeout" arguments are in
+// ticks: -1 means wait as long as it takes, 0 means don't wait.
+
+class Mailbox {
+  public:
+    Mailbox(char *debugName);		// initialize an empty mailbox
+    ~Mailbox();				// de-allocate a mailbox; nobody
+					// may be waiting on it
+
+    bool Send(char *data, int size);	// Send a message, waiting for room;
+					// FALSE if the mailbox is closed
+    bool SendMany(char **data, int *sizes, int count);
+					// Send "count" messages in order
+
+    int Receive(char *into, int size, int timeout);
+					// Receive a message into "into";
+					// return its length (the part that
+					// does not fit in "size" bytes is
+					// lost), or -1 if none came in time
+    int ReceiveMany(char **buffers, int *sizes, int max, int timeout);
+					// Receive up to "max" messages, as
+					// many as there are once one is in;
+					// "sizes" gives the size of each
+					// buffer, and is set to the length
+					// of each message.  Returns the
+					// number received
+
+    void Close();			// The receiver is finishing: make
+					// the senders give up
+    void Abandon();			// The receiver is gone: de-allocate
+					// the mailbox once no sender uses it
+
+  private:
+    bool WaitForMessage(int timeout);	// Wait for a message to come in
+
+    Lock *lock;				// protects the mailbox
+    Condition *notEmpty;		// signalled when a message comes in
+    char *name;				// useful for debugging
+    char buffer[MailboxSize];
+    int head;				// where the next message starts
+    int used;				// bytes in the buffer
+    Condition *notFull;			// signalled when messages are taken,
+					// or the mailbox is closed
+    bool closed;			// the receiver is finishing
+    bool abandoned;			// the receiver is gone
+    int senders;			// threads in SendMany
+
+    void Put(char *data, int size);	// Append bytes, wrapping around
+    void Get(char *data, int size);	// Remove bytes; NULL skips them
+    int Take(char *data, int size);	// Remove a whole message
+};
+
+#endif // MAILBOX_H
@@ -8,7 +8,7 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
+// Usage: nachos -d <debugflags> -rs <random seed #> -lockstat -smp <#cpus> -par
 //		-s -x <nachos file> -c <consoleIn> <consoleOut>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
@@ -18,6 +18,11 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -lockstat prints how much threads waited on each semaphore, lock,
+//	condition variable and reader/writer lock, when Nachos halts
+//    -smp simulates a multiprocessor with that many CPUs
+//    -par simulates the CPUs running user programs in parallel on the
+//	host (see cpu.h)
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
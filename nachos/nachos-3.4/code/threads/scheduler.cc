@@ -11,8 +11,18 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	The most urgent ready thread runs first; threads of the same
+//	priority run in FIFO order.  Priorities may change while threads
+//	wait (see Lock::Acquire), so the ready list is searched when a
+//	thread is picked, rather than kept sorted.
+//
+//	Threads are linked onto the ready list through a field of their
+//	own, so neither putting a thread on it nor taking one off
+//	allocates memory.
+//
+//	With -smp, each CPU has a ready list of its own, kept by the
+//	Multiprocessor (see cpu.h); these routines then work on the CPU
+//	being simulated.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -29,17 +39,19 @@
 
 Scheduler::Scheduler()
 { 
-    readyList = new List; 
+#ifdef USER_PROGRAM
+    switchedFrom = NULL;
+#endif
 } 
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
-// 	De-allocate the list of ready threads.
+// 	De-allocate the scheduler.  The ready list is linked through the
+//	threads themselves (see ilist.h), so there is nothing to free.
 //----------------------------------------------------------------------
 
 Scheduler::~Scheduler()
 { 
-    delete readyList; 
 } 
 
 //----------------------------------------------------------------------
@@ -56,14 +68,17 @@ Scheduler::ReadyToRun (Thread *thread)
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
-    //readyList->SortedInsert((void *)thread, thread->getPri());
+    if (smp != NULL)
+	smp->ReadyToRun(thread);	// on the ready list of its CPU
+    else
+	readyList.Append(thread);
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
 // 	Return the next thread to be scheduled onto the CPU.
-//	If there are no ready threads, return NULL.
+//	If there are no ready threads, return NULL; with -smp, the idle
+//	thread of the CPU instead.
 // Side effect:
 //	Thread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -83,7 +98,9 @@ Scheduler::FindNextToRun ()
     //printf("Thread: %d Priority: %d, Tick: %d\n", next->getTid(), pri, stats->totalTicks);
     return next;
     */
-    return (Thread *)readyList->Remove();
+    if (smp != NULL)
+	return smp->FindNextToRun();
+    return readyList.RemoveMin(ThreadPriority);
 }
 
 //----------------------------------------------------------------------
@@ -92,6 +109,13 @@ Scheduler::FindNextToRun ()
 //	and load the state of the new thread, by calling the machine
 //	dependent context switch routine, SWITCH.
 //
+//	Only the state that changes is saved and loaded.  A thread picked
+//	again (say, the only ready thread, after a Yield) just keeps the
+//	CPU, without a SWITCH.  The user registers are saved and loaded
+//	only for threads running a user program, and the address space
+//	only when the next thread runs in a different one: threads of the
+//	same process leave the page table and the TLB alone.
+//
 //      Note: we assume the state of the previously running thread has
 //	already been changed from running to blocked or ready (depending).
 // Side effect:
@@ -105,18 +129,46 @@ Scheduler::Run (Thread *nextThread)
 {
     Thread *oldThread = currentThread;
     
+    if (nextThread == oldThread) {	    // nothing to switch
+	currentThread->setStatus(RUNNING);
+	return;
+    }
+
 #ifdef USER_PROGRAM			// ignore until running user programs 
-    if (currentThread->space != NULL) {	// if this thread is a user program,
-        currentThread->SaveUserState(); // save the user's CPU registers
-	currentThread->space->SaveState();
+    if (oldThread->space != NULL) {	// if this thread is a user program,
+        oldThread->SaveUserState();	// save the user's CPU registers
+	if (nextThread->space != oldThread->space)
+	    oldThread->space->SaveState();
     }
+    switchedFrom = oldThread->space;
 #endif
-    
+    if (smp != NULL)
+	smp->Running()->switches++;
+    Switch(oldThread, nextThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Switch
+// 	The second half of Run: switch from oldThread, whose user state
+//	has been saved, to nextThread, and load the user state of the
+//	thread we come back in.  Also used by the Multiprocessor, to
+//	switch from the thread on one CPU to the thread on another.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Switch(Thread *oldThread, Thread *nextThread)
+{
+#ifdef USER_PROGRAM
+    AddrSpace *loaded;
+#endif
+
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
+    if (smp != NULL)
+	smp->Running()->current = nextThread;
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
 	  oldThread->getName(), nextThread->getName());
@@ -142,7 +194,11 @@ Scheduler::Run (Thread *nextThread)
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
         currentThread->RestoreUserState();     // to restore, do it.
-	currentThread->space->RestoreState();
+	loaded = switchedFrom;			// with -smp, each CPU has
+	if (smp != NULL)			// its own TLB
+	    loaded = smp->Running()->space;
+	if (currentThread->space != loaded)
+	    currentThread->space->RestoreState();
     }
 #endif
 }
@@ -155,6 +211,11 @@ Scheduler::Run (Thread *nextThread)
 void
 Scheduler::Print()
 {
+    ThreadQueue *queue = &readyList;
+
+    if (smp != NULL)
+	queue = &smp->Running()->readyList;
     printf("Ready list contents:\n");
-    readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    for (Thread *t = queue->Head(); t != NULL; t = queue->Next(t))
+	t->Print();
 }
@@ -10,7 +10,6 @@
 #define SCHEDULER_H
 
 #include "copyright.h"
-#include "list.h"
 #include "thread.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
@@ -26,11 +25,18 @@ class Scheduler {
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
+    void Switch(Thread* oldThread, Thread* nextThread);
+					// Switch the host from oldThread,
+					// whose user state is saved
     void Print();			// Print contents of ready list
     
   private:
-    List *readyList;  		// queue of threads that are ready to run,
+    ThreadQueue readyList;	// queue of threads that are ready to run,
 				// but not running
+#ifdef USER_PROGRAM
+    AddrSpace *switchedFrom;	// address space of the thread that gave
+				// up the CPU in the last context switch
+#endif
 };
 
 #endif // SCHEDULER_H
@@ -25,6 +25,99 @@
 #include "synch.h"
 #include "system.h"
 #include <stdio.h>
+#include <string.h>
+
+bool SynchStat::enabled = FALSE;
+SynchStat *SynchStat::all = NULL;
+
+//----------------------------------------------------------------------
+// SynchStat::Find
+// 	Return the contention statistics for the synchronization objects
+//	of some kind and name, or NULL if they are not being kept.
+//
+//	"name" is the debug name of the object
+//	"kind" says what sort of object it is
+//----------------------------------------------------------------------
+
+SynchStat *
+SynchStat::Find(char *name, SynchKind kind)
+{
+    SynchStat *stat;
+
+    if (!enabled)
+	return NULL;
+    for (stat = all; stat != NULL; stat = stat->next)
+	if (stat->kind == kind && !strcmp(stat->name, name))
+	    return stat;
+    stat = new SynchStat(name, kind);
+    stat->next = all;
+    all = stat;
+    return stat;
+}
+
+SynchStat::SynchStat(char *debugName, SynchKind synchKind)
+{
+    name = new char[strlen(debugName) + 1];	// the object's name may
+    strcpy(name, debugName);			// go before we print
+    kind = synchKind;
+    acquires = contended = totalWait = maxWait = 0;
+    maxHolder = -1;
+}
+
+//----------------------------------------------------------------------
+// SynchStat::Record
+// 	Count an acquire.  Called with interrupts off.
+//
+//	"waited" is how long the thread waited, -1 if it did not have to
+//	"holder" is the tid of the thread it waited for, -1 if unknown
+//----------------------------------------------------------------------
+
+void
+SynchStat::Record(int waited, int holder)
+{
+    acquires++;
+    if (waited < 0)
+	return;
+    contended++;
+    totalWait += waited;
+    if (waited >= maxWait) {
+	maxWait = waited;
+	maxHolder = holder;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchStat::PrintAll
+// 	Print the statistics, the objects waited on the longest first,
+//	since those are the bottlenecks.
+//----------------------------------------------------------------------
+
+void
+SynchStat::PrintAll()
+{
+    static char *kindName[] = { "semaphore", "lock", "condition", "rwlock",
+				"spinlock" };
+    SynchStat *stat, *max;
+    int printed = -1;
+
+    printf("Synchronization contention:\n");
+    for (;;) {				// selection sort, printing as we go
+	max = NULL;
+	for (stat = all; stat != NULL; stat = stat->next)
+	    if (stat->acquires > printed && (max == NULL ||
+		    stat->totalWait > max->totalWait))
+		max = stat;
+	if (max == NULL)
+	    break;
+	printf("%-9s %-20s acquires %d, contended %d, waited %d ticks "
+	    "(max %d", kindName[max->kind], max->name, max->acquires,
+	    max->contended, max->totalWait, max->maxWait);
+	if (max->maxHolder != -1)
+	    printf(", holder %d", max->maxHolder);
+	printf(")\n");
+	max->acquires = printed;	// so we skip it from now on
+    }
+}
 
 //----------------------------------------------------------------------
 // Semaphore::Semaphore
@@ -38,7 +131,7 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List;
+    stat = SynchStat::Find(debugName, SemaphoreKind);
 }
 
 //----------------------------------------------------------------------
@@ -49,7 +142,6 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 
 Semaphore::~Semaphore()
 {
-    delete queue;
 }
 
 //----------------------------------------------------------------------
@@ -66,17 +158,56 @@ void
 Semaphore::P()
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+    int start = (value == 0) ? stats->totalTicks : -1;
     
     while (value == 0) { 			// semaphore not available
-        queue->Append((void *)currentThread);	// so go to sleep
+        queue.Append(currentThread);	// so go to sleep
         currentThread->Sleep();
     } 
     value--; 					// semaphore available, 
 						// consume its value
+    if (stat != NULL)
+	stat->Record(start < 0 ? -1 : stats->totalTicks - start, -1);
     
     (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
 
+//----------------------------------------------------------------------
+// Semaphore::TimedP
+// 	Like P, but give up if the value is still 0 after a time limit.
+//	The thread sleeps until then, woken by its alarm.
+//
+// Returns:
+//	TRUE if the value was decremented, FALSE if time ran out.
+//
+//	"ticks" is the longest time to wait; 0 means don't wait.
+//----------------------------------------------------------------------
+
+bool
+Semaphore::TimedP(int ticks)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = (value == 0) ? stats->totalTicks : -1;
+    bool acquired;
+
+    if (value == 0 && ticks > 0) {
+	alarms->Set(currentThread, ticks);
+	while (value == 0 && !currentThread->timedOut) {
+	    queue.Append(currentThread);
+	    currentThread->Sleep();
+	}
+	alarms->Cancel(currentThread);
+    }
+    acquired = (value > 0);
+    if (acquired) {
+	value--;
+	if (stat != NULL)
+	    stat->Record(start < 0 ? -1 : stats->totalTicks - start, -1);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return acquired;
+}
+
 //----------------------------------------------------------------------
 // Semaphore::V
 // 	Increment semaphore value, waking up a waiter if necessary.
@@ -91,132 +222,638 @@ Semaphore::V()
     Thread *thread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    thread = (Thread *)queue->Remove();
+    thread = queue.RemoveMin(ThreadPriority);
     if (thread != NULL)	   // make thread ready, consuming the V immediately
 	    scheduler->ReadyToRun(thread);
     value++;
     (void) interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
+//----------------------------------------------------------------------
+// Lock::Lock
+// 	Initialize a lock, FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
 Lock::Lock(char* debugName) {
     name = debugName;
-    lock = new Semaphore("lock", 1);
     owner = NULL;
+    nextHeld = NULL;
+    stat = SynchStat::Find(debugName, LockKind);
 }
 
 Lock::~Lock() {
-    delete lock;
 }
 
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then take it.  While we wait, the
+//	holder runs at our priority, if it is less urgent than we are;
+//	the time spent waiting on such a holder is counted as priority
+//	inversion in the statistics.
+//----------------------------------------------------------------------
+
 void Lock::Acquire() {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
-    lock->P();
+    int start = stats->totalTicks;
+    bool inverted = FALSE;
+    int holder = (owner != NULL) ? owner->getTid() : -1;
+					// its tid: it may be gone by the
+					// time we get the lock
+    while (owner != NULL) {
+        if (owner->getBasePri() > currentThread->getPri()) {
+            inverted = TRUE;
+        }
+        currentThread->waitingOn = this;
+        Donate(currentThread->getPri());
+        queue.Append(currentThread);
+        currentThread->Sleep();
+    }
+    currentThread->waitingOn = NULL;
+    if (inverted) {
+        stats->numInversions++;
+        stats->inversionTicks += stats->totalTicks - start;
+    }
+    if (stat != NULL) {
+        stat->Record(holder == -1 ? -1 : stats->totalTicks - start, holder);
+    }
     owner = currentThread;
+    nextHeld = owner->heldLocks;
+    owner->heldLocks = this;
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Lock::TryAcquire
+// 	Take the lock if it is FREE, without waiting.
+//
+// Returns:
+//	TRUE if we now hold the lock.
+//----------------------------------------------------------------------
+
+bool Lock::TryAcquire() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    bool acquired = (owner == NULL);
+
+    if (acquired) {
+        owner = currentThread;
+        nextHeld = owner->heldLocks;
+        owner->heldLocks = this;
+        if (stat != NULL) {
+            stat->Record(-1, -1);
+        }
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return acquired;
+}
+
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Free the lock, give up any priority it brought us, and wake up
+//	the most urgent waiter, which competes for the lock again.  Only
+//	the holder may release the lock.
+//----------------------------------------------------------------------
+
 void Lock::Release() {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
-    lock->V();
+    Thread *thread;
+    Lock **ptr;
+
+    ASSERT(isHeldByCurrentThread());
+    for (ptr = &owner->heldLocks; *ptr != this; ptr = &(*ptr)->nextHeld) {
+        ASSERT(*ptr != NULL);
+    }
+    *ptr = nextHeld;
+    nextHeld = NULL;
+    owner->ResetPriority();
     owner = NULL;
+    thread = queue.RemoveMin(ThreadPriority);
+    if (thread != NULL) {
+        scheduler->ReadyToRun(thread);
+    }
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Lock::Donate
+// 	Pass a waiter's priority to the holder, and along the chain of
+//	locks the holders are themselves waiting for.  The chain stops at
+//	a holder that is already as urgent, or after MaxDonationDepth
+//	holders.  Called with interrupts off.
+//
+//	"pri" is the priority of the waiter
+//----------------------------------------------------------------------
+
+void Lock::Donate(int pri) {
+    Lock *lock = this;
+
+    for (int depth = 0; depth < MaxDonationDepth; depth++) {
+        if (lock == NULL || lock->owner == NULL ||
+                lock->owner->getPri() <= pri) {
+            return;
+        }
+        DEBUG('s', "Thread %d donates priority %d to thread %d\n",
+            currentThread->getTid(), pri, lock->owner->getTid());
+        lock->owner->Donate(pri);
+        lock = lock->owner->waitingOn;
+    }
+}
+
+//----------------------------------------------------------------------
+// Lock::WaiterPriority
+// 	Return the priority of the most urgent thread waiting for the
+//	lock, or a number larger than any priority if nobody is waiting.
+//----------------------------------------------------------------------
+
+int Lock::WaiterPriority() {
+    int pri = 0x7fffffff;
+
+    for (Thread *t = queue.Head(); t != NULL; t = queue.Next(t)) {
+        if (t->getPri() < pri) {	// interrupts are off
+            pri = t->getPri();
+        }
+    }
+    return pri;
+}
+
+bool Lock::isHeldByCurrentThread() {
+    return owner == currentThread;
+}
+
+//----------------------------------------------------------------------
+// Lock::IsBusy
+// 	Return TRUE if the lock is held, or some thread is waiting for
+//	it.  Interrupts must be off, so that the answer still holds when
+//	the caller acts on it.
+//----------------------------------------------------------------------
+
+bool Lock::IsBusy() {
+    return owner != NULL || !queue.IsEmpty();
+}
+
 
 Condition::Condition(char* debugName) {
     name = debugName;
-    queue = new List;
+    stat = SynchStat::Find(debugName, ConditionKind);
 }
 
 Condition::~Condition() {
-    delete queue;
 }
 
 void Condition::Wait(Lock* conditionLock) {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = stats->totalTicks;
+
+    conditionLock->Release();
+    queue.Append(currentThread);
+    currentThread->Sleep();
+    if (stat != NULL) {
+        stat->Record(stats->totalTicks - start, -1);
+    }
+    conditionLock->Acquire();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Condition::WaitFor
+// 	Like Wait, but for no longer than a time limit.  Either way, the
+//	lock is held again on return.
+//
+// Returns:
+//	TRUE if we were signalled, FALSE if time ran out.
+//
+//	"ticks" is the longest time to wait; 0 means don't wait.
+//----------------------------------------------------------------------
+
+bool Condition::WaitFor(Lock* conditionLock, int ticks) {
+    IntStatus oldLevel;
+    int start = stats->totalTicks;
+    bool signalled;
+
+    if (ticks <= 0) {
+        return FALSE;
+    }
+    oldLevel = interrupt->SetLevel(IntOff);
     conditionLock->Release();
-    queue->Append(currentThread);
+    queue.Append(currentThread);
+    alarms->Set(currentThread, ticks);
     currentThread->Sleep();
+    alarms->Cancel(currentThread);
+    signalled = !currentThread->timedOut;
+    if (stat != NULL) {
+        stat->Record(stats->totalTicks - start, -1);
+    }
     conditionLock->Acquire();
     (void) interrupt->SetLevel(oldLevel);
+    return signalled;
 }
 
 void Condition::Signal(Lock* conditionLock) {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
-    if (!queue->IsEmpty()) {
-        Thread* next = (Thread*)queue->Remove();
+    if (!queue.IsEmpty()) {
+        Thread* next = queue.RemoveMin(ThreadPriority);
         scheduler->ReadyToRun(next);
     }
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Condition::Broadcast
+// 	Wake up every waiter, in one pass over the queue.  They are all
+//	made ready together, so the order does not matter: the scheduler
+//	runs the most urgent first.
+//----------------------------------------------------------------------
+
 void Condition::Broadcast(Lock* conditionLock) {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
-    while (!queue->IsEmpty()) {
-        Signal(conditionLock);
+    Thread *thread;
+
+    while ((thread = queue.Remove()) != NULL) {
+        scheduler->ReadyToRun(thread);
     }
     (void) interrupt->SetLevel(oldLevel);
 }
 
-Condition *barrierCond = new Condition("Barrier Condition");
-Lock *barrierLock = new Lock("Barrier Lock");
-int barrierCnt = 0;
+//----------------------------------------------------------------------
+// Condition::HasWaiters
+// 	Return TRUE if some thread is waiting to be signalled.  Interrupts
+//	must be off, as for Lock::IsBusy.
+//----------------------------------------------------------------------
+
+bool Condition::HasWaiters() {
+    return !queue.IsEmpty();
+}
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader/writer lock, held by nobody.  The wait queues
+//	are part of the lock: there are no helper semaphores to allocate.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"pref" says whether arriving readers wait for queued writers
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char* debugName, RWPreference pref)
+{
+    name = debugName;
+    preference = pref;
+    readers = 0;
+    writing = FALSE;
+    waitingReaders = waitingWriters = 0;
+    stat = SynchStat::Find(debugName, RWLockKind);
+}
+
+RWLock::~RWLock()
+{
+    ASSERT(readers == 0 && !writing);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadAcquire
+// 	Share the lock with the other readers.  Wait while a writer holds
+//	it -- or, if writers are preferred, while one is waiting for it.
+//	A reader that waits holds the lock once it is woken.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReadAcquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = -1;
+
+    if (writing || (preference == PreferWriters && waitingWriters > 0)) {
+	start = stats->totalTicks;
+	waitingReaders++;
+	readQueue.Append(currentThread);
+	currentThread->Sleep();		// WakeReaders counted us in
+    } else
+	readers++;
+    if (stat != NULL)
+	stat->Record(start < 0 ? -1 : stats->totalTicks - start, -1);
+    (void) interrupt->SetLevel(oldLevel);
+}
 
-void Barrier(int max_num) {
-    barrierLock->Acquire();
-    barrierCnt++;
-    if (barrierCnt == max_num) {
-        printf("Process %d is waiting...  barrierCnt: %d  Broadcast!\n", currentThread->getTid(), barrierCnt);
-        barrierCond->Broadcast(barrierLock);
-        barrierLock->Release();
+//----------------------------------------------------------------------
+// RWLock::ReadRelease
+// 	A reader is done.  The last one out lets a writer in.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReadRelease()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(readers > 0);
+    readers--;
+    if (readers == 0 && waitingWriters > 0)
+	WakeWriter();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteAcquire
+// 	Hold the lock alone, waiting for the readers or the writer that
+//	hold it now to be done.
+//----------------------------------------------------------------------
+
+void
+RWLock::WriteAcquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = -1;
+
+    if (writing || readers > 0 || waitingWriters > 0) {
+	start = stats->totalTicks;
+	waitingWriters++;
+	writeQueue.Append(currentThread);
+	currentThread->Sleep();		// WakeWriter made us the writer
+    } else
+	writing = TRUE;
+    if (stat != NULL)
+	stat->Record(start < 0 ? -1 : stats->totalTicks - start, -1);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteRelease
+// 	The writer is done: let in the readers that queued up while it
+//	held the lock, or else the next writer.
+//----------------------------------------------------------------------
+
+void
+RWLock::WriteRelease()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(writing);
+    writing = FALSE;
+    if (waitingReaders > 0)
+	WakeReaders();
+    else if (waitingWriters > 0)
+	WakeWriter();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WakeReaders, RWLock::WakeWriter
+// 	Hand the lock over to the queued readers, all at once, or to the
+//	most urgent queued writer.  Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+RWLock::WakeReaders()
+{
+    Thread *thread;
+
+    DEBUG('s', "Letting %d readers into \"%s\"\n", waitingReaders, name);
+    while ((thread = readQueue.Remove()) != NULL) {
+	readers++;
+	waitingReaders--;
+	scheduler->ReadyToRun(thread);
     }
-    else {
-        printf("Process %d is waiting...  barrierCnt: %d\n", currentThread->getTid(), barrierCnt);
-        barrierCond->Wait(barrierLock);
-        barrierLock->Release();
+}
+
+void
+RWLock::WakeWriter()
+{
+    Thread *thread = writeQueue.RemoveMin(ThreadPriority);
+
+    ASSERT(thread != NULL);
+    waitingWriters--;
+    writing = TRUE;
+    scheduler->ReadyToRun(thread);
+}
+
+//----------------------------------------------------------------------
+// Barrier::Barrier
+// 	Initialize a barrier, with nobody waiting at it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"parties" is the number of threads that meet at each phase.
+//----------------------------------------------------------------------
+
+Barrier::Barrier(char* debugName, int numParties)
+{
+    ASSERT(numParties > 0);
+    name = debugName;
+    parties = numParties;
+    arrived = 0;
+    generation = 0;
+    phaseStart = 0;
+    totalWait = maxWait = 0;
+}
+
+Barrier::~Barrier()
+{
+    ASSERT(arrived == 0);
+}
+
+//----------------------------------------------------------------------
+// Barrier::Wait
+// 	Wait until all the parties have arrived.  The last one to arrive
+//	starts the next phase, and wakes everybody up.
+//
+// Returns:
+//	TRUE in the thread that arrived last, FALSE in the others, so that
+//	exactly one thread can do the work between two phases.
+//----------------------------------------------------------------------
+
+bool
+Barrier::Wait()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
+    int wait;
+
+    if (arrived == 0)
+	phaseStart = stats->totalTicks;
+    if (++arrived < parties) {
+	queue.Append(currentThread);
+	currentThread->Sleep();		// the last to arrive wakes us,
+	(void) interrupt->SetLevel(oldLevel);	// in the next generation
+	return FALSE;
     }
-    printf("Process %d continue...\n", currentThread->getTid());
+
+    wait = stats->totalTicks - phaseStart;
+    totalWait += wait;
+    if (wait > maxWait)
+	maxWait = wait;
+    DEBUG('s', "Barrier \"%s\" phase %d complete, after %d ticks\n",
+	name, generation, wait);
+    generation++;
+    arrived = 0;
+    while ((thread = queue.Remove()) != NULL)
+	scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Barrier::Print
+// 	Print how long the phases took to complete, from the first
+//	arrival to the last.
+//----------------------------------------------------------------------
+
+void
+Barrier::Print()
+{
+    printf("Barrier \"%s\": %d phases of %d threads", name, generation,
+	parties);
+    if (generation > 0)
+	printf(", %d ticks average wait, %d max", totalWait / generation,
+	    maxWait);
+    printf("\n");
 }
 
-/*
-RWLock::RWLock(char *debugName) {
+//----------------------------------------------------------------------
+// CountDownLatch::CountDownLatch
+// 	Initialize a latch, closed until "count" count-downs.
+//----------------------------------------------------------------------
+
+CountDownLatch::CountDownLatch(char* debugName, int initialCount)
+{
+    ASSERT(initialCount >= 0);
     name = debugName;
-    rcnt = 0;
-    rlock = new Lock("Read lock");
-    wlock = new Lock("Write lock");
+    count = initialCount;
+    closedAt = 0;			// may be built before the clock is
 }
 
-RWLock::~RWLock() {
-    delete rlock;
-    delete wlock;
+CountDownLatch::~CountDownLatch()
+{
+    ASSERT(queue.IsEmpty());
 }
 
-void RWLock::rP() {
-    rlock->Acquire();
-    rcnt++;
-    if (rcnt == 1) {
-        wlock->Acquire();
+//----------------------------------------------------------------------
+// CountDownLatch::CountDown
+// 	Count one down; the last count-down opens the latch, and lets
+//	everybody waiting for it go, in one pass.
+//----------------------------------------------------------------------
+
+void
+CountDownLatch::CountDown()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
+
+    ASSERT(count > 0);
+    if (--count == 0) {
+	DEBUG('s', "Latch \"%s\" open, after %d ticks\n", name,
+	    stats->totalTicks - closedAt);
+	while ((thread = queue.Remove()) != NULL)
+	    scheduler->ReadyToRun(thread);
     }
-    rlock->Release();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// CountDownLatch::Wait
+// 	Wait until the latch is open.  Returns straight away if it is.
+//----------------------------------------------------------------------
+
+void
+CountDownLatch::Wait()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (count > 0) {
+	queue.Append(currentThread);
+	currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// CountDownLatch::Reset
+// 	Close the latch again, for another round.  It must be open, so
+//	that nobody from the last round is still waiting.
+//
+//	"newCount" is the number of count-downs that will open it
+//----------------------------------------------------------------------
+
+void
+CountDownLatch::Reset(int newCount)
+{
+    ASSERT(count == 0 && newCount >= 0);
+    count = newCount;
+    closedAt = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// SpinLock::SpinLock
+// 	Initialize a spin lock, FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+SpinLock::SpinLock(char* debugName)
+{
+    name = debugName;
+    holder = NULL;
+    stat = SynchStat::Find(debugName, SpinLockKind);
 }
 
-void RWLock::rV() {
-    rlock->Acquire();
-    rcnt--;
-    if (rcnt == 0) {
-        wlock->Release();
+//----------------------------------------------------------------------
+// SpinLock::~SpinLock
+// 	De-allocate a spin lock, which nobody may hold.
+//----------------------------------------------------------------------
+
+SpinLock::~SpinLock()
+{
+    ASSERT(holder == NULL);
+}
+
+//----------------------------------------------------------------------
+// SpinLock::Acquire
+// 	Spin until the lock is FREE, then take it.  Each spin turns
+//	interrupts on and off again, which takes a tick, so that time
+//	passes, interrupts are taken, and the other CPUs get to run.  If
+//	the holder is on our CPU, it only runs if we yield to it.
+//----------------------------------------------------------------------
+
+void
+SpinLock::Acquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = stats->totalTicks;
+    int spinning = (holder != NULL) ? holder->getTid() : -1;
+					// the holder's tid, for the stats
+
+    ASSERT(holder != currentThread);
+    while (holder != NULL) {
+	if (smp == NULL || holder->cpu == smp->Running())
+	    currentThread->Yield();
+	(void) interrupt->SetLevel(IntOn);
+	(void) interrupt->SetLevel(IntOff);
+    }
+    holder = currentThread;
+    if (stat != NULL) {
+	stat->Record(spinning == -1 ? -1 : stats->totalTicks - start,
+	    spinning);
     }
-    rlock->Release();
+    (void) interrupt->SetLevel(oldLevel);
 }
 
-void RWLock::wP() {
-    wlock->Acquire();
+//----------------------------------------------------------------------
+// SpinLock::Release
+// 	Free the lock.  Nobody needs waking: the threads waiting for it
+//	see it is FREE the next time they look.
+//----------------------------------------------------------------------
+
+void
+SpinLock::Release()
+{
+    ASSERT(holder == currentThread);
+    holder = NULL;
 }
 
-void RWLock::wV() {
-    wlock->Release();
+//----------------------------------------------------------------------
+// SpinLock::isHeldByCurrentThread
+// 	Return TRUE if the current thread holds the lock.
+//----------------------------------------------------------------------
+
+bool
+SpinLock::isHeldByCurrentThread()
+{
+    return holder == currentThread;
 }
-*/
\ No newline at end of file
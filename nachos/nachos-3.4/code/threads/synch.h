@@ -21,6 +21,45 @@
 #include "thread.h"
 #include "list.h"
 
+// Contention statistics, kept when Nachos is run with -lockstat, and
+// printed when it halts.  There is one record per kind and name of
+// synchronization object, shared by every object of that name: for
+// each, how many times it was acquired (or waited on, for a condition
+// variable), how many of those had to wait, the time spent waiting,
+// and the thread holding a lock during the longest wait.
+
+enum SynchKind { SemaphoreKind, LockKind, ConditionKind, RWLockKind,
+		 SpinLockKind };
+
+class SynchStat {
+  public:
+    static bool enabled;		// set by -lockstat
+    static SynchStat *Find(char *name, SynchKind kind);
+					// The record for "name", created
+					// the first time it is needed
+    static void PrintAll();		// Print every record, the most
+					// waited on first
+
+    void Record(int waited, int holder);
+					// An acquire, after waiting for
+					// "waited" ticks (-1 if it did not
+					// have to) on thread "holder" (-1
+					// if unknown)
+
+  private:
+    SynchStat(char *name, SynchKind kind);
+
+    char *name;
+    SynchKind kind;
+    int acquires;			// acquires, or waits on a condition
+    int contended;			// the ones that had to wait
+    int totalWait, maxWait;		// ticks spent waiting
+    int maxHolder;			// tid of the lock holder during
+					// the longest wait, -1 if unknown
+    SynchStat *next;
+    static SynchStat *all;		// every record
+};
+
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
 //
@@ -44,11 +83,15 @@ class Semaphore {
     
     void P();	 // these are the only operations on a semaphore
     void V();	 // they are both *atomic*
+
+    bool TimedP(int ticks);	// P, but give up after "ticks" of
+				// simulated time; TRUE if it succeeded
     
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List *queue;       // threads waiting in P() for the value to be > 0
+    ThreadQueue queue; // threads waiting in P() for the value to be > 0
+    SynchStat *stat;   // contention statistics, if -lockstat
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -62,6 +105,12 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// A thread waiting for a lock donates its priority to the holder, and
+// on to whatever the holder is waiting for, so that a less urgent
+// holder cannot keep it waiting behind threads of middle priority.
+// Waiters, on locks as on semaphores and condition variables, are
+// woken most urgent first.
 
 class Lock {
   public:
@@ -72,16 +121,30 @@ class Lock {
     void Acquire(); // these are the only operations on a lock
     void Release(); // they are both *atomic*
 
+    bool TryAcquire();			// Acquire, if the lock is FREE;
+					// TRUE if it was
+
     bool isHeldByCurrentThread();	// true if the current thread
 					// holds this lock.  Useful for
 					// checking in Release, and in
 					// Condition variable ops below.
 
+    int WaiterPriority();		// Priority of the most urgent
+					// waiter, or a number larger than
+					// any priority if there is none
+    bool IsBusy();			// Held, or waited for?  Call with
+					// interrupts off
+    Lock *nextHeld;			// next lock held by the owner
+
   private:
+    void Donate(int pri);		// Raise the priority of the owner,
+					// and of the owners of the locks it
+					// is waiting for, to "pri"
+
     char* name;				// for debugging
-    Thread* owner;
-    Semaphore* lock;
-    // plus some other stuff you'll need to define
+    Thread* owner;			// NULL if the lock is FREE
+    ThreadQueue queue;			// threads waiting in Acquire
+    SynchStat *stat;			// contention statistics
 };
 
 // The following class defines a "condition variable".  A condition
@@ -131,29 +194,137 @@ class Condition {
     void Broadcast(Lock *conditionLock);// the currentThread for all of 
 					// these operations
 
+    bool WaitFor(Lock *conditionLock, int ticks);
+					// Wait, but for no more than "ticks"
+					// of simulated time; TRUE if
+					// signalled in time
+    bool HasWaiters();			// Is any thread waiting?  Call
+					// with interrupts off
+
   private:
     char* name;
-    List* queue;
-    // plus some other stuff you'll need to define
+    ThreadQueue queue;			// threads waiting to be signalled
+    SynchStat *stat;			// contention statistics
 };
-#endif // SYNCH_H
 
-void Barrier(int num);
-/*
+// The following class defines a "reader/writer lock".  Any number of
+// readers may hold it at once, or else a single writer.
+//
+//	ReadAcquire/ReadRelease -- share the lock with other readers
+//
+//	WriteAcquire/WriteRelease -- hold the lock alone
+//
+// With PreferWriters, a reader arriving while a writer waits queues up
+// behind it; with PreferReaders, it joins the readers holding the lock.
+// Either way, when a writer releases the lock, all the readers queued
+// meanwhile are let in together, as one batch, before the next writer.
+// So with PreferWriters neither side can starve the other; with
+// PreferReaders, a steady stream of readers keeps writers waiting for
+// as long as it lasts.  The lock is handed over to the threads it
+// wakes, so nobody can slip in before them.
+
+enum RWPreference { PreferReaders, PreferWriters };
+
 class RWLock {
   public:
-    RWLock(char *debugName);
+    RWLock(char* debugName, RWPreference pref = PreferWriters);
     ~RWLock();
-    char *getName() { return (name); }
-    void rP();
-    void rV();
-    void wP();
-    void wV();
+    char* getName() { return name; }
+
+    void ReadAcquire();
+    void ReadRelease();
+    void WriteAcquire();
+    void WriteRelease();
 
   private:
-    char *name;
-    int rcnt;
-    Lock *rlock;
-    Lock *wlock;
+    void WakeReaders();			// Let in all the queued readers
+    void WakeWriter();			// Let in the most urgent writer
+
+    char* name;
+    RWPreference preference;
+    int readers;			// readers holding the lock
+    bool writing;			// held by a writer?
+    int waitingReaders, waitingWriters;
+    ThreadQueue readQueue;		// threads waiting to read
+    ThreadQueue writeQueue;		// threads waiting to write
+    SynchStat *stat;			// contention statistics
 };
-*/
\ No newline at end of file
+
+// The following class defines a "barrier": a meeting point for a
+// fixed number of threads, each of which waits there until all of them
+// have arrived.  The last one to arrive releases the others, all in one
+// pass, and the barrier is ready for the next phase straight away: a
+// generation count tells the threads of one phase from those of the
+// next, so a fast thread coming round again cannot slip through.
+
+class Barrier {
+  public:
+    Barrier(char* debugName, int parties);	// "parties" threads meet
+    ~Barrier();					// nobody may be waiting
+    char* getName() { return name; }
+
+    bool Wait();			// Wait for the others; TRUE in the
+					// thread that completed the phase
+    int getPhase() { return generation; }	// phases completed so far
+    void Print();			// Print the timing of the phases
+
+  private:
+    char* name;
+    int parties;			// threads that meet at each phase
+    int arrived;			// threads waiting in this phase
+    int generation;			// phases completed
+    ThreadQueue queue;			// threads waiting in this phase
+    int phaseStart;			// when the first thread arrived
+    int totalWait, maxWait;		// ticks from the first arrival to
+					// the last, over all phases
+};
+
+// The following class defines a "count-down latch": threads wait until
+// others have counted it down to zero, after which it stays open.  It
+// may be reset for another round, once it is open.
+
+class CountDownLatch {
+  public:
+    CountDownLatch(char* debugName, int count);	// closed, at "count"
+    ~CountDownLatch();				// nobody may be waiting
+    char* getName() { return name; }
+
+    void CountDown();			// Open the latch if this brings
+					// the count to zero
+    void Wait();			// Wait until the latch is open
+    int getCount() { return count; }
+    void Reset(int count);		// Close the latch again, at "count"
+
+  private:
+    char* name;
+    int count;				// count-downs still to come
+    ThreadQueue queue;			// threads waiting for it to open
+    int closedAt;			// when it was closed
+};
+
+// The following class defines a "spin lock", for data shared by
+// threads running on different CPUs of a multiprocessor (see cpu.h),
+// held for a short while.  A thread waiting for it does not sleep, but
+// keeps its CPU, burning simulated time, until the holder, running on
+// another CPU, releases it.  If the holder cannot run unless we let
+// it, because it is waiting for our very CPU (always the case with one
+// CPU), we yield to it between spins.
+
+class SpinLock {
+  public:
+    SpinLock(char* debugName);		// initialize lock to be FREE
+    ~SpinLock();			// it must be FREE
+    char* getName() { return name; }
+
+    void Acquire();			// Spin until it is FREE, and take it
+    void Release();			// Free it
+
+    bool isHeldByCurrentThread();
+
+  private:
+    char* name;
+    Thread* holder;			// NULL if the lock is FREE
+    SynchStat *stat;			// contention statistics
+};
+
+#endif // SYNCH_H
\ No newline at end of file
@@ -1,11 +1,17 @@
-// synchlist.h 
-//	Data structures for synchronized access to a list.
+// synchlist.h
+//	Data structures for synchronized access to a queue.
 //
 //	Implemented by surrounding the List abstraction
 //	with synchronization routines.
 //
+// 	Implemented in "monitor"-style -- surround each procedure with a
+// 	lock acquire and release pair, using condition signal and wait for
+// 	synchronization.
+//
+//	All the routines are defined here, since SynchQueue is a template.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
-// All rights reserved.  See copyright.h for copyright notice and limitation 
+// All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
 
 #ifndef SYNCHLIST_H
@@ -15,28 +21,129 @@
 #include "list.h"
 #include "synch.h"
 
-// The following class defines a "synchronized list" -- a list for which:
-// these constraints hold:
-//	1. Threads trying to remove an item from a list will
-//	wait until the list has an element on it.
-//	2. One thread at a time can access list data structures
+// The following class defines a "synchronized queue" -- a queue of
+// items of type T for which these constraints hold:
+//	1. Threads trying to get an item from the queue will
+//	wait until the queue has an item on it.
+//	2. If the queue was given a capacity, threads trying to put
+//	an item on a full queue wait until there is room for it.
+//	3. One thread at a time can access the queue data structures
 
-class SynchList {
+template <class T>
+class SynchQueue {
   public:
-    SynchList();		// initialize a synchronized list
-    ~SynchList();		// de-allocate a synchronized list
+    SynchQueue(int maxItems = 0);	// initialize a synchronized queue,
+					// holding at most "maxItems" items
+					// (0 for no limit)
+    ~SynchQueue();			// de-allocate a synchronized queue
 
-    void Append(void *item);	// append item to the end of the list,
-				// and wake up any thread waiting in remove
-    void *Remove();		// remove the first item from the front of
-				// the list, waiting if the list is empty
-				// apply function to every item in the list
-    void Mapcar(VoidFunctionPtr func);
+    void Put(T item);		// append item to the end of the queue,
+				// waiting for room if it is full, and wake
+				// up any thread waiting in Get
+    T Get();			// remove the first item from the front of
+				// the queue, waiting if the queue is empty
+    void Mapcar(void (*func)(T));	// apply function to every item
+					// on the queue
 
   private:
-    List *list;			// the unsynchronized list
+    List<T> list;		// the unsynchronized queue
+    int count;			// items on the queue
+    int capacity;		// the most it may hold, 0 for no limit
     Lock *lock;			// enforce mutual exclusive access to the list
-    Condition *listEmpty;	// wait in Remove if the list is empty
+    Condition *listEmpty;	// wait in Get if the queue is empty
+    Condition *listFull;	// wait in Put if the queue is full
 };
 
+//----------------------------------------------------------------------
+// SynchQueue<T>::SynchQueue
+//	Allocate and initialize the data structures needed for a
+//	synchronized queue, empty to start with.
+//	Items can now be put on the queue.
+//----------------------------------------------------------------------
+
+template <class T>
+SynchQueue<T>::SynchQueue(int maxItems)
+{
+    ASSERT(maxItems >= 0);
+    count = 0;
+    capacity = maxItems;
+    lock = new Lock("list lock");
+    listEmpty = new Condition("list empty cond");
+    listFull = new Condition("list full cond");
+}
+
+//----------------------------------------------------------------------
+// SynchQueue<T>::~SynchQueue
+//	De-allocate the data structures created for synchronizing a queue.
+//----------------------------------------------------------------------
+
+template <class T>
+SynchQueue<T>::~SynchQueue()
+{
+    delete lock;
+    delete listEmpty;
+    delete listFull;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue<T>::Put
+//      Append an "item" to the end of the queue, once there is room for
+//	it.  Wake up anyone waiting for an item to be appended.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SynchQueue<T>::Put(T item)
+{
+    lock->Acquire();		// enforce mutual exclusive access to the list
+    while (capacity > 0 && count == capacity)
+	listFull->Wait(lock);	// wait until there is room
+    list.Append(item);
+    count++;
+    listEmpty->Signal(lock);	// wake up a waiter, if any
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchQueue<T>::Get
+//      Remove an "item" from the beginning of the queue.  Wait if
+//	the queue is empty.
+// Returns:
+//	The removed item.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+SynchQueue<T>::Get()
+{
+    T item;
+
+    lock->Acquire();			// enforce mutual exclusion
+    while (list.IsEmpty())
+	listEmpty->Wait(lock);		// wait until list isn't empty
+    item = list.Remove();
+    count--;
+    if (capacity > 0)
+	listFull->Signal(lock);		// make room for a waiting Put
+    lock->Release();
+    return item;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue<T>::Mapcar
+//      Apply function to every item on the queue.  Obey the same rules
+//	on synchronization as for Get and Put.
+//
+//	"func" is the procedure to be applied.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SynchQueue<T>::Mapcar(void (*func)(T))
+{
+    lock->Acquire();
+    list.Mapcar(func);
+    lock->Release();
+}
+
 #endif // SYNCHLIST_H
@@ -7,12 +7,12 @@
 
 #include "copyright.h"
 #include "system.h"
+#include "synch.h"
 #include <stdio.h>
 
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
 
-Message msg[20];
 Thread *currentThread;			// the thread we are running now
 Thread *threadToBeDestroyed;  		// the thread that just finished
 Scheduler *scheduler;			// the ready list
@@ -20,6 +20,8 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+Alarm *alarms;				// time limits of kernel threads
+Multiprocessor *smp;			// the CPUs, NULL if there is one
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -31,6 +33,9 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+FrameTable *frameTable;	// owner of every physical page frame
+ProcessTable *processTable;	// every user process, by process id
+ExecImageCache *imageCache;	// executables recently run
 #endif
 
 #ifdef NETWORK
@@ -59,12 +64,18 @@ int Thread::valid_id[128];
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
+//	With user programs, the timer also drives working set sampling
+//	(see FrameTable::SampleReferences).
+//
 //	"dummy" is because every interrupt handler takes one argument,
 //		whether it needs it or not.
 //----------------------------------------------------------------------
 static void
 TimerInterruptHandler(int dummy)
 {
+#ifdef USER_PROGRAM
+    frameTable->SampleReferences();
+#endif
     if (interrupt->getStatus() != IdleMode)
 	interrupt->YieldOnReturn();
 }
@@ -85,6 +96,8 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    int numCpus = 1;
+    bool runParallel = FALSE;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
@@ -112,6 +125,14 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-lockstat")) {
+	    SynchStat::enabled = TRUE;	// see synch.h
+	} else if (!strcmp(*argv, "-smp")) {
+	    ASSERT(argc > 1);
+	    numCpus = atoi(*(argv + 1));	// see cpu.h
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-par")) {
+	    runParallel = TRUE;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
@@ -138,6 +159,7 @@ Initialize(int argc, char **argv)
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new Scheduler();		// initialize the ready queue
+    alarms = new Alarm();			// no thread is sleeping yet
     if (randomYield) {				// start the timer (if needed)
 	    timer = new Timer(TimerInterruptHandler, 0, randomYield);
         printf("timer OK\n");
@@ -149,10 +171,6 @@ Initialize(int argc, char **argv)
     // But if it ever tries to give up the CPU, we better have a Thread
     // object to save its state. 
 
-    for (int i = 0; i < 20; i++) {
-        msg[i].valid = false;
-    }
-
     Thread::init();
     currentThread = Thread::createThread("main");		
     currentThread->setStatus(RUNNING);
@@ -162,6 +180,9 @@ Initialize(int argc, char **argv)
     
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
+    frameTable = new FrameTable();
+    processTable = new ProcessTable();
+    imageCache = new ExecImageCache();
 #endif
 
 #ifdef FILESYS
@@ -175,6 +196,16 @@ Initialize(int argc, char **argv)
 #ifdef NETWORK
     postOffice = new PostOffice(netname, rely, 10);
 #endif
+
+    smp = NULL;
+#ifdef USER_PROGRAM
+    if (debugUserProg)				// one instruction at a time
+	runParallel = FALSE;
+#endif
+    if (numCpus > 1) {		// after the machine, whose TLB is the first CPU's
+	smp = new Multiprocessor(numCpus, runParallel);
+	smp->Start();
+    }
 }
 
 //----------------------------------------------------------------------
@@ -189,7 +220,12 @@ Cleanup()
     delete postOffice;
 #endif
     
+    delete smp;
+
 #ifdef USER_PROGRAM
+    delete processTable;
+    delete imageCache;
+    delete frameTable;
     delete machine;
 #endif
 
@@ -202,6 +238,7 @@ Cleanup()
 #endif
     
     delete timer;
+    delete alarms;
     delete scheduler;
     delete interrupt;
     
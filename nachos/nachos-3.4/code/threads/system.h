@@ -15,6 +15,8 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "alarm.h"
+#include "cpu.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -22,17 +24,24 @@ extern void Initialize(int argc, char **argv); 	// Initialization,
 extern void Cleanup();				// Cleanup, called when
 						// Nachos is done.
 
-extern Message msg[20];
 extern Thread *currentThread;			// the thread holding the CPU
 extern Thread *threadToBeDestroyed;  		// the thread that just finished
 extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern Alarm *alarms;				// time limits on waits
+extern Multiprocessor *smp;			// the CPUs, with -smp
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "frametable.h"
+#include "process.h"
+#include "execimage.h"
 extern Machine* machine;	// user program memory and registers
+extern FrameTable *frameTable;	// owner of every physical page frame
+extern ProcessTable *processTable;	// every user process, by process id
+extern ExecImageCache *imageCache;	// executables recently run
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
@@ -19,12 +19,9 @@
 #include "switch.h"
 #include "synch.h"
 #include "system.h"
+#include "mailbox.h"
 #include <string.h>
 
-#define STACK_FENCEPOST 0xdeadbeef	// this is put at the top of the
-					// execution stack, for detecting 
-					// stack overflows
-
 void* thread_pointer[128];
 
 
@@ -46,19 +43,23 @@ Thread::Thread(char* threadName)
     tid = getNewId();
     thread_pointer[tid] = this;
     uid = 0;
-    priority = 0;
+    priority = basePriority = 0;
+    waitingOn = NULL;
+    heldLocks = NULL;
+    timedOut = FALSE;
+    cpu = NULL;
     //(void) interrupt->SetLevel(oldLevel);
 
-    for (int i = 0; i < 10; i++) {
-        child[i] = NULL;
-    }
-    father = this;
-
     stackTop = NULL;
     stack = NULL;
+    fence = NULL;
     status = JUST_CREATED;
+    mailbox = NULL;			// most threads never get a message
 #ifdef USER_PROGRAM
     space = NULL;
+    process = NULL;
+    userStack = -1;
+    inSyscall = FALSE;
 #endif
 }
 
@@ -79,6 +80,8 @@ Thread::~Thread()
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
+    if (mailbox != NULL)
+	mailbox->Abandon();		// senders may still be in it
     //printf("i will be delete. tid=%d\n", tid);
 
     if (stack != NULL)
@@ -121,32 +124,6 @@ Thread::Fork(VoidFunctionPtr func, int arg)
     (void) interrupt->SetLevel(oldLevel);
 }    
 
-//----------------------------------------------------------------------
-// Thread::CheckOverflow
-// 	Check a thread's stack to see if it has overrun the space
-//	that has been allocated for it.  If we had a smarter compiler,
-//	we wouldn't need to worry about this, but we don't.
-//
-// 	NOTE: Nachos will not catch all stack overflow conditions.
-//	In other words, your program may still crash because of an overflow.
-//
-// 	If you get bizarre results (such as seg faults where there is no code)
-// 	then you *may* need to increase the stack size.  You can avoid stack
-// 	overflows by not putting large data structures on the stack.
-// 	Don't do this: void foo() { int bigArray[10000]; ... }
-//----------------------------------------------------------------------
-
-void
-Thread::CheckOverflow()
-{
-    if (stack != NULL)
-#ifdef HOST_SNAKE			// Stacks grow upward on the Snakes
-	ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
-#else
-	ASSERT((int) *stack == (int) STACK_FENCEPOST);
-#endif
-}
-
 //----------------------------------------------------------------------
 // Thread::Finish
 // 	Called by ThreadRoot when a thread is done executing the 
@@ -158,6 +135,9 @@ Thread::CheckOverflow()
 //	so that Scheduler::Run() will call the destructor, once we're
 //	running in the context of a different thread.
 //
+//	Our mailbox is closed first, so that senders waiting for room in
+//	it give up, rather than wait for a thread that is gone.
+//
 // 	NOTE: we disable interrupts, so that we don't get a time slice 
 //	between setting threadToBeDestroyed, and going to sleep.
 //----------------------------------------------------------------------
@@ -166,6 +146,8 @@ Thread::CheckOverflow()
 void
 Thread::Finish ()
 {
+    if (mailbox != NULL)
+	mailbox->Close();			// no more messages
     (void) interrupt->SetLevel(IntOff);		
     ASSERT(this == currentThread);
     
@@ -209,8 +191,8 @@ Thread::Yield ()
     
     DEBUG('t', "Yielding thread \"%s\"\n", getName());
     
-    if (priority < 4)
-        priority++;
+    if (basePriority < 4)
+        setPri(basePriority + 1);
     //printf("oooooops\n");
     scheduler->ReadyToRun(this);
     nextThread = scheduler->FindNextToRun();
@@ -251,6 +233,10 @@ Thread::Sleep ()
     
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
+#ifdef USER_PROGRAM
+    if (inSyscall)			// the process may want to run
+	BlockedInSyscall(this);		// something else meanwhile
+#endif
     status = BLOCKED;
     while ((nextThread = scheduler->FindNextToRun()) == NULL)
 	    interrupt->Idle();	// no one to run, wait for an interrupt
@@ -258,6 +244,28 @@ Thread::Sleep ()
     scheduler->Run(nextThread); // returns when we've been signalled
 }
 
+//----------------------------------------------------------------------
+// Thread::SleepFor
+// 	Relinquish the CPU for a while, without using any of it: the
+//	thread is woken by its alarm.
+//
+//	"ticks" is how long to sleep, in simulated time
+//----------------------------------------------------------------------
+
+void
+Thread::SleepFor(int ticks)
+{
+    IntStatus oldLevel;
+
+    ASSERT(this == currentThread);
+    if (ticks <= 0)
+	return;
+    oldLevel = interrupt->SetLevel(IntOff);
+    alarms->Set(this, ticks);
+    Sleep();
+    alarms->Cancel(this);		// in case we were woken otherwise
+    (void) interrupt->SetLevel(oldLevel);
+}
 
 char* getThreadStatus(ThreadStatus status, char *s) {
   switch (status) {
@@ -277,41 +285,52 @@ char* getThreadStatus(ThreadStatus status, char *s) {
   return s;
 }
 
-bool Thread::SendMsg(char* buffer, int des) {
-    int msg_idx = -1;
-    for (int i = 0; i < 20; i++) {
-        if (!msg[i].valid) {
-            msg_idx = i;
-            break;
-        }
-    }
-    if (msg_idx == -1) {
-        return false;
-    }
-    printf("You are sending a message: %s\n", buffer);
-    //msg[msg_idx].data = buffer;
-    strncpy(msg[msg_idx], buffer, strlen(buffer));
-    msg[msg_idx].des = des;
-    msg[msg_idx].size = strlen(buffer);
-    msg[msg_idx].valid = true;
-    printf("Message send success!\n");
-    return true;
+//----------------------------------------------------------------------
+// Thread::SendMsg
+// 	Put a message in the mailbox of another thread, waiting if the
+//	mailbox is full.  Returns FALSE if there is no thread "des", or
+//	it finishes before the message is in.
+//
+//	"data", "size" are the message, and its length
+//	"des" is the tid of the receiving thread
+//----------------------------------------------------------------------
+
+bool
+Thread::SendMsg(char* data, int size, int des)
+{
+    if (des < 0 || des >= max_thread || valid_id[des] == 0)
+	return FALSE;
+    return ((Thread *) thread_pointer[des])->GetMailbox()->Send(data, size);
 }
 
-bool Thread::GetMsg(char* buffer) {
-    printf("You are getting a message\n");
-    int tmp_tid = currentThread->getTid();
-    bool flag = false;
-    for (int i = 0; i < 20; i++) {
-        if (msg[i].valid && msg[i].des == tmp_tid) {
-            strncpy(buffer, msg[i].data, msg[i].size);
-            msg[i].valid = false;
-            flag = true;
-            break;
-        }
-    }
-    printf("Message get success!\n");
-    return flag;
+//----------------------------------------------------------------------
+// Thread::GetMsg
+// 	Wait for a message in our own mailbox, and return its length.
+//
+//	"buffer", "size" are where to put the message, and how much room
+//	there is
+//----------------------------------------------------------------------
+
+int
+Thread::GetMsg(char* buffer, int size)
+{
+    return GetMailbox()->Receive(buffer, size, -1);
+}
+
+//----------------------------------------------------------------------
+// Thread::GetMailbox
+// 	Return the mailbox of this thread, creating it on the first
+//	message sent or received: most threads never get one.  Creating
+//	it gives up the CPU nowhere, so the sender and the receiver cannot
+//	both create one.
+//----------------------------------------------------------------------
+
+Mailbox *
+Thread::GetMailbox()
+{
+    if (mailbox == NULL)
+	mailbox = new Mailbox(name);
+    return mailbox;
 }
 
 //----------------------------------------------------------------------
@@ -325,6 +344,38 @@ bool Thread::GetMsg(char* buffer) {
 static void ThreadFinish()    { currentThread->Finish(); }
 static void InterruptEnable() { interrupt->Enable(); }
 void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
+int ThreadPriority(Thread *thread) { return thread->getPri(); }
+
+//----------------------------------------------------------------------
+// Thread::setPri
+// 	Set the thread's own priority.  It keeps running at a donated
+//	priority, if that is more urgent, until it releases its locks.
+//----------------------------------------------------------------------
+
+void
+Thread::setPri(int pri)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    basePriority = pri;
+    ResetPriority();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Thread::ResetPriority
+// 	Recompute the priority the thread runs at: its own, or that of
+//	the most urgent thread waiting for one of the locks it holds.
+//	Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+Thread::ResetPriority()
+{
+    priority = basePriority;
+    for (Lock *lock = heldLocks; lock != NULL; lock = lock->nextHeld)
+	Donate(lock->WaiterPriority());
+}
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
@@ -346,7 +397,7 @@ Thread::StackAllocate (VoidFunctionPtr func, int arg)
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
     stackTop = stack + 16;	// HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
+    fence = &stack[StackSize - 1];
 #else
     // i386 & MIPS & SPARC stack works from high addresses to low addresses
 #ifdef HOST_SPARC
@@ -362,8 +413,9 @@ Thread::StackAllocate (VoidFunctionPtr func, int arg)
     *(--stackTop) = (int)ThreadRoot;
 #endif
 #endif  // HOST_SPARC
-    *stack = STACK_FENCEPOST;
+    fence = stack;
 #endif  // HOST_SNAKE
+    *fence = STACK_FENCEPOST;
     
     machineState[PCState] = (int) ThreadRoot;
     machineState[StartupPCState] = (int) InterruptEnable;
@@ -382,13 +434,22 @@ Thread::StackAllocate (VoidFunctionPtr func, int arg)
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
 //	while executing kernel code.  This routine saves the former.
+//
+//	"engine" simulates the CPU whose registers are saved; by
+//	default, the machine being simulated
 //----------------------------------------------------------------------
 
 void
 Thread::SaveUserState()
+{
+    SaveUserState(machine);
+}
+
+void
+Thread::SaveUserState(Machine *engine)
 {
     for (int i = 0; i < NumTotalRegs; i++)
-	userRegisters[i] = machine->ReadRegister(i);
+	userRegisters[i] = engine->ReadRegister(i);
 }
 
 //----------------------------------------------------------------------
@@ -398,12 +459,21 @@ Thread::SaveUserState()
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
 //	while executing kernel code.  This routine restores the former.
+//
+//	"engine" simulates the CPU whose registers are loaded; by
+//	default, the machine being simulated
 //----------------------------------------------------------------------
 
 void
 Thread::RestoreUserState()
+{
+    RestoreUserState(machine);
+}
+
+void
+Thread::RestoreUserState(Machine *engine)
 {
     for (int i = 0; i < NumTotalRegs; i++)
-	machine->WriteRegister(i, userRegisters[i]);
+	engine->WriteRegister(i, userRegisters[i]);
 }
 #endif
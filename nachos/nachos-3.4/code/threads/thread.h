@@ -39,11 +39,14 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "ilist.h"
 #include <string.h>
 
 #ifdef USER_PROGRAM
 #include "machine.h"
 #include "addrspace.h"
+
+class Process;
 #endif
 
 // CPU register state to be saved on context switch.  
@@ -56,6 +59,10 @@
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 #define StackSize	(4 * 1024)	// in words
 
+#define STACK_FENCEPOST 0xdeadbeef	// this is put at the top of the
+					// execution stack, for detecting 
+					// stack overflows
+
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
@@ -67,13 +74,12 @@ extern void ThreadPrint(int arg);
 
 extern void* thread_pointer[128];
 
-class Message {
-  public:
-    bool valid;
-    char* data;
-    int size;
-    int des;
-};
+class Mailbox;
+class Lock;
+class Cpu;
+
+#define MaxDonationDepth	8	// longest chain of lock holders a
+					// priority is donated along
 
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
@@ -119,16 +125,43 @@ class Thread {
 						// relinquish the processor
     void Finish();  				// The thread is done executing
     
-    void CheckOverflow();   			// Check if thread has 
+    void CheckOverflow()   			// Check if thread has 
+	{ ASSERT(fence == NULL || *fence == (int) STACK_FENCEPOST); }
 						// overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
     char* getName() { return (name); }
     void Print() { printf("%s, ", name); }
     int getTid() { return tid; }
     int getUid() { return uid; }
 
-    int getPri() { return priority; }
-    void setPri(int pri) { priority = pri; }
+    // Priorities: the smaller the number, the more urgent the thread.
+    // A thread holding locks runs at the priority of the most urgent
+    // thread waiting for one of them, if that is more urgent than its own.
+    int getPri() { return priority; }	// priority it runs at
+    int getBasePri() { return basePriority; }	// its own priority
+    void setPri(int pri);		// Set its own priority
+    void Donate(int pri) { if (pri < priority) priority = pri; }
+					// Run at "pri", on behalf of a
+					// thread waiting for our lock
+    void ResetPriority();		// Recompute the priority, when a
+					// lock is released
+
+    Lock *waitingOn;			// lock it is waiting to acquire
+    Lock *heldLocks;			// locks it holds, chained through
+					// Lock::nextHeld
+
+    ListLink<Thread> queueLink;		// links on the ready list, or on
+					// the queue it is blocked in
+
+    void SleepFor(int ticks);		// Sleep for "ticks" of simulated
+					// time
+    ListLink<Thread> alarmLink;		// on the alarm list, while it
+					// waits with a time limit
+    bool timedOut;			// woken by its alarm, rather than
+					// by what it was waiting for
+    Cpu *cpu;				// the CPU it runs on, or last ran
+					// on, with -smp; NULL until then
 
 
     static int getCnt() { return thread_cnt; }
@@ -159,11 +192,11 @@ class Thread {
       printf("----------------------------------\n");
     }
 
-    Thread* child[10];
-    Thread* father;
-
-    bool SendMsg(char* buffer, int des);
-    bool GetMsg(char* buffer);
+    bool SendMsg(char* data, int size, int des);
+					// Send a message to thread "des";
+					// FALSE if there is no such thread
+    int GetMsg(char* buffer, int size);	// Wait for a message; return
+					// its length
 
 
   private:
@@ -172,6 +205,9 @@ class Thread {
     int* stack; 	 		// Bottom of the stack 
 					// NULL if this is the main thread
 					// (If NULL, don't deallocate stack)
+    int* fence;				// word of the stack holding the
+					// STACK_FENCEPOST, which an overflow
+					// overwrites first; NULL if no stack
     ThreadStatus status;		// ready, running or blocked
     char* name;
     int tid;
@@ -181,12 +217,17 @@ class Thread {
     static int valid_id[128]; // number of thread in history, used to assign tid
     static const int max_thread = 128;
 
-    int priority;
+    int priority;			// donated, or else basePriority
+    int basePriority;
 
     void StackAllocate(VoidFunctionPtr func, int arg);
     					// Allocate a stack for thread.
 					// Used internally by Fork()
 
+    Mailbox *mailbox;			// Messages sent to this thread;
+					// NULL until the first one
+    Mailbox *GetMailbox();		// Create it if need be
+
 
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
@@ -198,11 +239,33 @@ class Thread {
   public:
     void SaveUserState();		// save user-level register state
     void RestoreUserState();		// restore user-level register state
+    void SaveUserState(Machine *engine); // the same, for the registers
+    void RestoreUserState(Machine *engine); // of another simulated CPU
 
     AddrSpace *space;			// User code this thread is running.
+    Process *process;			// Process it belongs to
+    int userStack;			// Initial stack pointer, if the
+					// stack came from ThreadCreate;
+					// -1 for the first thread
+    bool inSyscall;			// In a system call that makes an
+					// upcall if it blocks
 #endif
 };
 
+// A queue of threads, linked through Thread::queueLink; see ilist.h.
+
+typedef IntrusiveList<Thread, &Thread::queueLink> ThreadQueue;
+
+extern int ThreadPriority(Thread *thread);	// the priority of a thread,
+						// as a key for RemoveMin
+
+#ifdef USER_PROGRAM
+extern void BlockedInSyscall(Thread *thread);
+					// Make an upcall for a thread that
+					// blocks in a system call (see
+					// exception.cc)
+#endif
+
 // Magical machine-dependent routines, defined in switch.s
 
 extern "C" {
@@ -13,7 +13,9 @@
 #include "system.h"
 #include <string.h>
 #include <stdio.h>
+#include <sys/time.h>
 #include "synch.h"
+#include "synchlist.h"
 
 // testnum is set in main.cc
 int testnum = 1;
@@ -38,9 +40,48 @@ SimpleThread(int which)
     }
 }
 
+//----------------------------------------------------------------------
+// BarrierTest
+// 	Run BarrierThreads threads through BarrierPhases phases, meeting
+//	at a barrier at the end of each; the threads do different amounts
+//	of work in each phase.  The main thread waits on a latch until
+//	they are all done.
+//----------------------------------------------------------------------
+
+#define BarrierThreads	5
+#define BarrierPhases	3
+
+static Barrier *phaseBarrier;
+static CountDownLatch *doneLatch;
+
+static void
+BarrierThread(int which)
+{
+    for (int phase = 0; phase < BarrierPhases; phase++) {
+	for (int i = 0; i < (which + phase) % BarrierThreads; i++)
+	    currentThread->Yield();
+	printf("Thread %d done with phase %d\n", which, phase);
+	if (phaseBarrier->Wait())
+	    printf("Thread %d completed phase %d\n", which, phase);
+    }
+    doneLatch->CountDown();
+}
+
 void
-BarrierTest(int which) {
-    Barrier(5);
+BarrierTest()
+{
+    Thread *t;
+
+    phaseBarrier = new Barrier("phase", BarrierThreads);
+    doneLatch = new CountDownLatch("done", BarrierThreads);
+    for (int i = 0; i < BarrierThreads; i++) {
+	t = Thread::createThread("barrier test");
+	t->Fork(BarrierThread, i);
+    }
+    doneLatch->Wait();
+    phaseBarrier->Print();
+    delete phaseBarrier;
+    delete doneLatch;
 }
 
 //----------------------------------------------------------------------
@@ -218,9 +259,11 @@ void TestPipe() {
 
 void TestMsgChild(int n) {
     char data[10];
-    currentThread->GetMsg(data);
+    int len = currentThread->GetMsg(data, 9);
+    data[len] = '\0';
     printf("I am child, receive: %s\n", data);
-    currentThread->GetMsg(data);
+    len = currentThread->GetMsg(data, 9);
+    data[len] = '\0';
     printf("I am child, receive: %s\n", data);
 }
 
@@ -229,14 +272,229 @@ void TestMsg() {
     strcpy(input, "hello");
     Thread* thread = new Thread("Child");
     printf("I am main thread, send msg: %s\n", input);
-    currentThread->SendMsg(input, thread->getTid());
+    currentThread->SendMsg(input, strlen(input), thread->getTid());
     char input2[10];
     strcpy(input2, "world");
     printf("I am main thread, send msg: %s\n", input2);
-    currentThread->SendMsg(input2, thread->getTid());
+    currentThread->SendMsg(input2, strlen(input2), thread->getTid());
     thread->Fork(TestMsgChild, 0);
     currentThread->Yield();
 }
+//----------------------------------------------------------------------
+// ListBenchmark
+// 	Time the queue operations, in host nanoseconds per item: a List,
+//	which allocates an element per item, against a ThreadQueue, which
+//	links the items themselves; a SortedList; and a bounded
+//	SynchQueue between two threads, which adds the cost of the
+//	context switches when the queue fills up or runs dry.
+//----------------------------------------------------------------------
+
+#define BenchItems	100000
+#define BenchCapacity	8
+
+static double
+HostNanos()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+static SynchQueue<int> *benchQueue;
+
+static void
+BenchProducer(int n)
+{
+    for (int i = 0; i < n; i++)
+	benchQueue->Put(i);
+}
+
+void
+ListBenchmark()
+{
+    List<Thread *> list;
+    ThreadQueue queue;
+    SortedList<int, int> sorted;
+    Thread *t;
+    double start;
+    int i, sum = 0;
+
+    start = HostNanos();
+    for (i = 0; i < BenchItems; i++) {
+	list.Append(currentThread);
+	(void) list.Remove();
+    }
+    printf("List<Thread *>:      %6.1f ns/item\n",
+	(HostNanos() - start) / BenchItems);
+
+    start = HostNanos();
+    for (i = 0; i < BenchItems; i++) {
+	queue.Append(currentThread);
+	(void) queue.Remove();
+    }
+    printf("ThreadQueue:         %6.1f ns/item\n",
+	(HostNanos() - start) / BenchItems);
+
+    start = HostNanos();
+    for (i = 0; i < BenchItems; i++) {
+	sorted.Insert(i, i % 7);
+	if (i % 4 == 3)
+	    while (!sorted.IsEmpty())
+		sum += sorted.Remove(NULL);
+    }
+    printf("SortedList<int,int>: %6.1f ns/item\n",
+	(HostNanos() - start) / BenchItems);
+
+    benchQueue = new SynchQueue<int>(BenchCapacity);
+    t = Thread::createThread("producer");
+    start = HostNanos();
+    t->Fork(BenchProducer, BenchItems);
+    for (i = 0; i < BenchItems; i++)
+	sum += benchQueue->Get();
+    printf("SynchQueue<int>(%d):  %6.1f ns/item\n", BenchCapacity,
+	(HostNanos() - start) / BenchItems);
+    delete benchQueue;
+    DEBUG('t', "Benchmark checksum %d\n", sum);
+}
+
+//----------------------------------------------------------------------
+// TimeoutTest
+// 	Exercise the timed waits: a semaphore nobody signals, one that is
+//	signalled in time, and a thread that sleeps for a while.
+//----------------------------------------------------------------------
+
+static Semaphore *timeoutSem;
+
+static void
+TimeoutSignaller(int ticks)
+{
+    currentThread->SleepFor(ticks);
+    printf("Signaller woke at %d\n", stats->totalTicks);
+    timeoutSem->V();
+}
+
+void
+TimeoutTest()
+{
+    Thread *t;
+    bool acquired;
+
+    timeoutSem = new Semaphore("timeout test", 0);
+    acquired = timeoutSem->TimedP(500);
+    printf("TimedP(500) with no V: %s at %d\n",
+	acquired ? "acquired" : "timed out", stats->totalTicks);
+
+    t = Thread::createThread("signaller");
+    t->Fork(TimeoutSignaller, 200);
+    acquired = timeoutSem->TimedP(1000);
+    printf("TimedP(1000) with a V after 200: %s at %d\n",
+	acquired ? "acquired" : "timed out", stats->totalTicks);
+    delete timeoutSem;
+}
+
+//----------------------------------------------------------------------
+// SwitchBenchmark
+// 	Time context switches, in switches per host second: two threads
+//	yielding to each other, which switch on every Yield, and a thread
+//	yielding with no one else ready, which keeps the CPU.
+//----------------------------------------------------------------------
+
+#define BenchSwitches	100000
+
+static void
+SwitchPartner(int n)
+{
+    for (int i = 0; i < n; i++)
+	currentThread->Yield();
+}
+
+void
+SwitchBenchmark()
+{
+    Thread *t;
+    double start, elapsed;
+    int i;
+
+    start = HostNanos();
+    for (i = 0; i < BenchSwitches; i++)
+	currentThread->Yield();
+    elapsed = HostNanos() - start;
+    printf("Yield, no one ready:  %10.0f yields/s\n",
+	BenchSwitches * 1e9 / elapsed);
+
+    t = Thread::createThread("switch partner");
+    start = HostNanos();
+    t->Fork(SwitchPartner, BenchSwitches);
+    for (i = 0; i < BenchSwitches; i++)
+	currentThread->Yield();
+    elapsed = HostNanos() - start;
+    printf("Yield, ping-pong:     %10.0f switches/s\n",
+	2 * BenchSwitches * 1e9 / elapsed);
+}
+
+//----------------------------------------------------------------------
+// SmpTest
+// 	Exercise the multiprocessor (run with -smp <#cpus>): worker
+//	threads, all forked on the first CPU, so the others have to steal
+//	them, take turns at a spin lock around a shared counter, working
+//	some of the time with the lock held, and some without.  With
+//	-lockstat, Nachos reports how long they spun when it halts.
+//----------------------------------------------------------------------
+
+#define SmpWorkers	8
+#define SmpRounds	20
+
+static SpinLock *counterLock;
+static CountDownLatch *workersDone;
+static int counter;
+
+static void
+Compute(int ticks)
+{
+    for (int t = 0; t < ticks; t += SystemTick) {	// each takes a tick
+	(void) interrupt->SetLevel(IntOff);
+	(void) interrupt->SetLevel(IntOn);
+    }
+}
+
+static void
+SmpWorker(int which)
+{
+    int value;
+
+    for (int i = 0; i < SmpRounds; i++) {
+	Compute(200);			// work of its own
+	counterLock->Acquire();
+	value = counter;
+	Compute(50);			// work on the shared data
+	counter = value + 1;
+	counterLock->Release();
+    }
+    workersDone->CountDown();
+}
+
+void
+SmpTest()
+{
+    Thread *t;
+    int start = stats->totalTicks;
+
+    counterLock = new SpinLock("counter");
+    workersDone = new CountDownLatch("workers", SmpWorkers);
+    counter = 0;
+    for (int i = 0; i < SmpWorkers; i++) {
+	t = Thread::createThread("smp worker");
+	t->Fork(SmpWorker, i);
+    }
+    workersDone->Wait();
+    printf("%d workers on %d CPUs: counter %d (expected %d), %d ticks\n",
+	SmpWorkers, (smp != NULL) ? smp->NumCpus() : 1, counter,
+	SmpWorkers * SmpRounds, stats->totalTicks - start);
+    delete counterLock;
+    delete workersDone;
+}
+
 //----------------------------------------------------------------------
 // ThreadTest
 // 	Invoke a test routine.
@@ -251,6 +509,21 @@ ThreadTest()
 	//ThreadTest4();
     //Thread::ts();
 	break;
+    case 2:
+	ListBenchmark();
+	break;
+    case 3:
+	BarrierTest();
+	break;
+    case 4:
+	TimeoutTest();
+	break;
+    case 5:
+	SwitchBenchmark();
+	break;
+    case 6:
+	SmpTest();
+	break;
     default:
 	printf("No test specified.\n");
 	break;
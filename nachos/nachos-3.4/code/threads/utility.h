@@ -15,6 +15,7 @@
 //   	'f' -- file system (FILESYS)
 //   	'a' -- address spaces (USER_PROGRAM)
 //   	'n' -- network emulation (NETWORK)
+//   	'c' -- system calls (USER_PROGRAM)
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -50,6 +51,7 @@
 
 typedef void (*VoidFunctionPtr)(int arg); 
 typedef void (*VoidNoArgFunctionPtr)(); 
+typedef int (*IntFunctionPtr)(int arg);	// computes a key, for instance
 
 
 // Include interface that isolates us from the host machine system library.
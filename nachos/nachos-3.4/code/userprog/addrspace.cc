@@ -18,33 +18,29 @@
 #include "copyright.h"
 #include "system.h"
 #include "addrspace.h"
-#include "noff.h"
 #include "openfile.h"
 #include <stdio.h>
 #ifdef HOST_SPARC
 #include <strings.h>
 #endif
 
+int AddrSpace::nextSpaceId = 0;
+
 //----------------------------------------------------------------------
-// SwapHeader
-// 	Do little endian to big endian conversion on the bytes in the 
-//	object file header, in case the file was generated on a little
-//	endian machine, and we're now running on a big endian machine.
+// InvalidateTLB
+// 	Invalidate the entries of a TLB that translate "vpn", folding
+//	their dirty bits into the page table entry "entry".
 //----------------------------------------------------------------------
 
-static void 
-SwapHeader (NoffHeader *noffH)
+static void
+InvalidateTLB(TranslationEntry *tlb, int vpn, TranslationEntry *entry)
 {
-	noffH->noffMagic = WordToHost(noffH->noffMagic);
-	noffH->code.size = WordToHost(noffH->code.size);
-	noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
-	noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
-	noffH->initData.size = WordToHost(noffH->initData.size);
-	noffH->initData.virtualAddr = WordToHost(noffH->initData.virtualAddr);
-	noffH->initData.inFileAddr = WordToHost(noffH->initData.inFileAddr);
-	noffH->uninitData.size = WordToHost(noffH->uninitData.size);
-	noffH->uninitData.virtualAddr = WordToHost(noffH->uninitData.virtualAddr);
-	noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
+    for (int i = 0; i < TLBSize; i++)
+	if (tlb[i].valid && tlb[i].virtualPage == vpn) {
+	    if (tlb[i].dirty)
+		entry->dirty = TRUE;
+	    tlb[i].valid = FALSE;
+	}
 }
 
 //----------------------------------------------------------------------
@@ -55,9 +51,18 @@ SwapHeader (NoffHeader *noffH)
 //
 //	Assumes that the object code file is in NOFF format.
 //
-//	First, set up the translation from program memory to physical 
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+//	The heap starts out empty, just past the uninitialized data, and
+//	grows up with Sbrk; the stack is at the end of the address space,
+//	and grows down as it is used, into the UserGrowSize bytes left
+//	between them.
+//
+//	The translation is a two-level page table, and every page starts
+//	out invalid.  The code and data are faulted in on demand from the
+//	image of the executable, which is cached, so that running the same
+//	program again reads nothing from the disk; pages that have been
+//	modified and evicted are read back from a per-address-space swap
+//	file.  So the virtual address space may be larger than physical
+//	memory.
 //
 //	"executable" is the file containing the object code to load into memory
 //----------------------------------------------------------------------
@@ -65,116 +70,98 @@ SwapHeader (NoffHeader *noffH)
 AddrSpace::AddrSpace(OpenFile *executable)
 {
     NoffHeader noffH;
-    unsigned int i, size;
+    unsigned int size;
+    int textFirst, textEnd;
 
-    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-    if ((noffH.noffMagic != NOFFMAGIC) && 
-		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
-    	SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
+    image = imageCache->Get(executable);
+    noffH = image->noffH;
 
 // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size 
-			+ UserStackSize;	// we need to increase the size
-						// to leave room for the stack
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size;
+    heapStart = brk = divRoundUp(size, PageSize) * PageSize;
+    size = heapStart + UserGrowSize + UserStackSize;
+						// we need to increase the size
+						// to leave room for the heap
+						// and the stack
     numPages = divRoundUp(size, PageSize);
+    stackBottom = numPages - divRoundUp(UserStackSize, PageSize);
+    stackEnd = numPages;
     size = numPages * PageSize;
-    //printf("numpages: %d\n", numPages);
-    //printf("numphyspage: %d\n", NumPhysPages);
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
+					// no need to check against
+					// NumPhysPages: pages are only
+					// brought into memory on demand
 
     DEBUG('a', "Initializing address space, num pages %d, size %d\n", 
 					numPages, size);
-// first, set up the translation 
-    //pageTable = new TranslationEntry[numPages];
-    pageTable = new TranslationEntry[NumPhysPages];
-    for (i = 0; i < NumPhysPages; i++) {
-        pageTable[i].virtualPage = -1;	// for now, virtual page # = phys page #
-        //pageTable[i].physicalPage = machine->bitmap->find();
-        pageTable[i].physicalPage = i;
-        pageTable[i].valid = FALSE;
-
-        pageTable[i].use = FALSE;
-        pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE;  // if the code segment was entirely on 
-                        // a separate page, we could set its 
-                        // pages to be read-only
-    }
-    
-    fileSystem->Create("virtual_memory", size);
-    OpenFile *openfile = fileSystem->Open("virtual_memory");
-    if (openfile == NULL)
-        ASSERT(false);
-    if (noffH.code.size > 0) {
-        int pos1 = noffH.code.inFileAddr;
-        int pos2 = noffH.code.virtualAddr;
-        char current_char;
-        for (int j = 0; j < noffH.code.size; j++) {
-            executable->ReadAt(&(current_char), 1, pos1++);
-            openfile->WriteAt(&(current_char), 1, pos2++);
-        }
-    }
-    if (noffH.initData.size > 0) {
-        int pos1 = noffH.initData.inFileAddr;
-        int pos2 = noffH.initData.virtualAddr;
-        char current_char;
-        for (int j = 0; j < noffH.initData.size; j++) {
-            executable->ReadAt(&(current_char), 1, pos1++);
-            openfile->WriteAt(&(current_char), 1, pos2++);
-        }
-    }
-    delete openfile;
-
-// zero out the entire address space, to zero the unitialized data segment 
-// and the stack segment
-    //bzero(machine->mainMemory, size);
-
-// then, copy in the code and data segments into memory
-/*
-    if (noffH.code.size > 0) {
-        DEBUG('a', "Initializing code segment, at 0x%x, size %d\n", 
-			noffH.code.virtualAddr, noffH.code.size);
-        
-        //executable->ReadAt(&(machine->mainMemory[noffH.code.virtualAddr]),
-		//	noffH.code.size, noffH.code.inFileAddr);
-        
-        int code_pos = noffH.code.inFileAddr;
-        for (int i = 0; i < noffH.code.size; i++) {
-            int vpn = (noffH.code.virtualAddr + i) / PageSize;
-            int offset = (noffH.code.virtualAddr + i) % PageSize;
-            int phyAddr = pageTable[vpn].physicalPage * PageSize + offset;
-            executable->ReadAt(&(machine->mainMemory[phyAddr]), 1, code_pos++);
-        }
-    }
-    if (noffH.initData.size > 0) {
-        DEBUG('a', "Initializing data segment, at 0x%x, size %d\n", 
-			noffH.initData.virtualAddr, noffH.initData.size);
-        
-        //executable->ReadAt(&(machine->mainMemory[noffH.initData.virtualAddr]),
-		//	noffH.initData.size, noffH.initData.inFileAddr);
-        
-        int data_pos = noffH.initData.inFileAddr;
-        for (int i = 0; i < noffH.initData.size; i++) {
-            int vpn = (noffH.initData.virtualAddr + i) / PageSize;
-            int offset = (noffH.initData.virtualAddr + i) % PageSize;
-            int phyAddr = pageTable[vpn].physicalPage * PageSize + offset;
-            executable->ReadAt(&(machine->mainMemory[phyAddr]), 1, data_pos++);
-        }
-    }
-    */
+// first, set up the translation.  Nothing is mapped yet; every page
+// is brought in the first time it is touched.
+    pageTable = new PageTable(numPages);
+
+// then, create the swap file.  Nothing is written to it until a page
+// is evicted: until then, code and initialized data are copied from
+// the image, and the other pages (uninitialized data, heap, stack) are
+// taken from the pool of zeroed frames on their first fault.  The file
+// grows as pages are written to it.
+    sprintf(swapName, "virtual_memory%d", nextSpaceId++);
+    fileSystem->Create(swapName, 0);
+    swapFile = fileSystem->Open(swapName);
+    ASSERT(swapFile != NULL);
+    onDisk = new BitMap(numPages);
+
+// the pages holding nothing but code are shared with the other
+// processes running the same program, if any
+    textFirst = divRoundUp(noffH.code.virtualAddr, PageSize);
+    textEnd = (noffH.code.virtualAddr + noffH.code.size) / PageSize;
+    if (noffH.initData.size > 0 &&
+		(int) (noffH.initData.virtualAddr / PageSize) < textEnd)
+	textEnd = noffH.initData.virtualAddr / PageSize;
+    if (noffH.uninitData.size > 0 &&
+		(int) (noffH.uninitData.virtualAddr / PageSize) < textEnd)
+	textEnd = noffH.uninitData.virtualAddr / PageSize;
+    text = NULL;
+    frameTable->lock->Acquire();
+    if (noffH.code.size > 0 && textEnd > textFirst)
+	text = SharedText::Attach(image, textFirst, textEnd - textFirst);
+    if (text != NULL)
+	text->AddUser(this);
+    frameTable->lock->Release();
+
+    for (int r = 0; r < MaxMappings; r++)
+	regions[r].file = NULL;
+    for (int s = 0; s < MaxThreadStacks; s++) {
+	stackVpn[s] = -1;
+	stackInUse[s] = FALSE;
+    }
+
+    refCount = 1;
+    frameTable->lock->Acquire();
+    frameTable->AddSpace(this);
+    frameTable->lock->Release();
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.  Nothing for now!
+// 	Dealloate an address space: give back its frames, and throw
+//	away its page table and its swap file.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
-   delete pageTable;
+    if (smp != NULL)
+	smp->Forget(this);
+    frameTable->lock->Acquire();
+    for (int r = 0; r < MaxMappings; r++)
+	if (regions[r].file != NULL)
+	    regions[r].file->Unmap(this, regions[r].firstVpn);
+    frameTable->RemoveSpace(this);
+    if (text != NULL)
+	text->RemoveUser(this);
+    frameTable->lock->Release();
+    delete pageTable;
+    delete onDisk;
+    delete swapFile;
+    fileSystem->Remove(swapName);
+    imageCache->Release(image);
 }
 
 //----------------------------------------------------------------------
@@ -214,22 +201,598 @@ AddrSpace::InitRegisters()
 // 	On a context switch, save any machine state, specific
 //	to this address space, that needs saving.
 //
-//	For now, nothing!
+//	With a TLB, the use and dirty bits live in the TLB while we run,
+//	so copy them back into the page table.
 //----------------------------------------------------------------------
 
 void AddrSpace::SaveState() 
-{}
+{
+    SyncTLB();
+}
 
 //----------------------------------------------------------------------
 // AddrSpace::RestoreState
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      Tell the machine where to find the page table, and flush the
+//	TLB, which holds translations of the previous address space.
+//	With -smp, this is the TLB of the CPU being simulated, which
+//	remembers whose translations it now holds.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+    if (machine->tlb != NULL)
+	for (int i = 0; i < TLBSize; i++)
+	    machine->tlb[i].valid = FALSE;
+    if (smp != NULL)
+	smp->Running()->space = this;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PageIn
+// 	Handle a page fault: find a frame for a virtual page, and fill it.
+//	A page of a mapped file maps the frame the file page is in, and a
+//	page of shared code maps the frame of the shared text.  A page
+//	with a copy in the swap file is read from there; a page of code
+//	or data that has not been evicted yet is copied from the image
+//	of the executable; any other page (uninitialized data, stack)
+//	gets a zeroed frame, no I/O.  A page the pager is still writing
+//	out just takes its frame back.
+//
+//	The caller must hold frameTable->lock.
+//
+//	"vpn" is the faulting virtual page
+//----------------------------------------------------------------------
+
+void
+AddrSpace::PageIn(int vpn)
+{
+    TranslationEntry *entry = pageTable->Fetch(vpn);
+    MapRegion *region;
+    int frame, numRead;
+    char *page;
+
+    ASSERT(!entry->valid);
+    stats->numPageFaults++;
+    if (frameTable->Reclaim(this, vpn, entry->physicalPage)) {
+	entry->valid = TRUE;
+	entry->dirty = TRUE;		// the write may miss later changes
+	return;
+    }
+    if ((region = FindRegion(vpn)) != NULL) {	// map the file page
+	entry->physicalPage = region->file->Fault(region->firstPage +
+					vpn - region->firstVpn);
+	entry->valid = TRUE;
+	entry->use = FALSE;
+	entry->dirty = FALSE;
+	entry->readOnly = FALSE;
+	entry->shared = TRUE;		// other mappers see the stores
+	return;
+    }
+    if (IsText(vpn)) {			// map the shared copy
+	entry->physicalPage = text->Fault(vpn);
+	entry->valid = TRUE;
+	entry->use = FALSE;
+	entry->dirty = FALSE;
+	entry->readOnly = TRUE;
+	entry->shared = FALSE;
+	return;
+    }
+
+    frame = frameTable->AllocateFrame(this, vpn,
+		!onDisk->Test(vpn) && vpn >= image->numPages);
+    page = &machine->mainMemory[frame * PageSize];
+    if (onDisk->Test(vpn)) {
+	numRead = swapFile->ReadAt(page, PageSize, vpn * PageSize);
+	ASSERT(numRead == PageSize);
+    } else if (vpn < image->numPages)
+	bcopy(image->Page(vpn), page, PageSize);
+    DEBUG('a', "Paged in vpn %d to frame %d\n", vpn, frame);
+
+    entry->physicalPage = frame;
+    entry->valid = TRUE;
+    entry->use = FALSE;
+    entry->dirty = FALSE;
+    entry->readOnly = FALSE;
+    entry->shared = FALSE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Unmap
+// 	Invalidate the translation of a virtual page (also in the TLB,
+//	if this address space is loaded; with -smp, in the TLB of every
+//	CPU it is loaded on), and return whether the page has been
+//	modified since it was paged in.  Its frame, which the page table
+//	entry still points to, is dealt with by the caller.
+//
+//	"vpn" is the virtual page to unmap
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::Unmap(int vpn)
+{
+    TranslationEntry *entry = pageTable->Lookup(vpn);
+    bool dirty;
+
+    ASSERT(entry != NULL && entry->valid);
+    if (machine->tlb != NULL && smp != NULL) {
+	for (int c = 0; c < smp->NumCpus(); c++)
+	    if (smp->GetCpu(c)->space == this)
+		InvalidateTLB(smp->GetCpu(c)->tlb, vpn, entry);
+    } else if (machine->tlb != NULL && machine->pageTable == pageTable)
+	InvalidateTLB(machine->tlb, vpn, entry);
+    dirty = entry->dirty;
+    entry->valid = FALSE;
+    entry->dirty = FALSE;
+    return dirty;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::WriteSwap
+// 	Write consecutive virtual pages to the swap file with a single
+//	write, and remember they now have a copy there.  The pages are
+//	copied out of their frames first, so the frames may change once
+//	we block on the disk.
+//
+//	"vpn" is the first virtual page of the run
+//	"frames" are the frames holding the pages, in order
+//	"count" is the number of pages
+//----------------------------------------------------------------------
+
+void
+AddrSpace::WriteSwap(int vpn, int *frames, int count)
+{
+    char *buffer = new char[count * PageSize];
+    int length = swapFile->Length();
+
+    if (length < vpn * PageSize) {	// fill the hole, the file system
+	char *zeroes = new char[vpn * PageSize - length];  // cannot skip it
+
+	bzero(zeroes, vpn * PageSize - length);
+	swapFile->WriteAt(zeroes, vpn * PageSize - length, length);
+	delete [] zeroes;
+    }
+    for (int i = 0; i < count; i++) {
+	bcopy(&machine->mainMemory[frames[i] * PageSize],
+		&buffer[i * PageSize], PageSize);
+	onDisk->Mark(vpn + i);
+    }
+    swapFile->WriteAt(buffer, count * PageSize, vpn * PageSize);
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PageOut
+// 	Evict a virtual page from its frame, writing it to the swap file
+//	if it has been modified since it was paged in.  The frame itself
+//	is recycled by the caller.
+//
+//	"vpn" is the virtual page to evict
+//----------------------------------------------------------------------
+
+void
+AddrSpace::PageOut(int vpn)
+{
+    int frame = pageTable->Lookup(vpn)->physicalPage;
+
+    if (Unmap(vpn)) {
+	DEBUG('a', "Writing back vpn %d from frame %d\n", vpn, frame);
+	WriteSwap(vpn, &frame, 1);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Mmap
+// 	Map part of a file into the address space, at new virtual pages
+//	past the end of the stack.  Nothing is read now: the pages are
+//	faulted in from the file, and shared with any other process that
+//	has the file mapped.
+//
+//	"file" is the open file to map
+//	"offset" is where the mapping starts in the file; must be a
+//		multiple of PageSize
+//	"length" is the number of bytes to map
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Mmap(OpenFile *file, int offset, int length)
+{
+    MapRegion *region = NULL;
+    int count;
+
+    if (file == NULL || offset < 0 || offset % PageSize != 0 || length <= 0)
+	return -1;
+    for (int r = 0; r < MaxMappings; r++)
+	if (regions[r].file == NULL) {
+	    region = &regions[r];
+	    break;
+	}
+    if (region == NULL)
+	return -1;
+
+    count = divRoundUp(length, PageSize);
+    frameTable->lock->Acquire();
+    region->file = MappedFile::Map(file, this, numPages, offset / PageSize,
+				count);
+    if (region->file != NULL) {
+	region->firstPage = offset / PageSize;
+	region->numPages = count;
+	region->firstVpn = AllocateRegion(count);
+    }
+    frameTable->lock->Release();
+    if (region->file == NULL)
+	return -1;
+    return region->firstVpn * PageSize;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Munmap
+// 	Remove a mapping made by Mmap.  Pages dirtied through it are
+//	written back to the file.  The virtual pages are not reused.
+//
+//	"addr" is the address Mmap returned
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Munmap(int addr)
+{
+    MapRegion *region = FindRegion((unsigned) addr / PageSize);
+
+    if (region == NULL || region->firstVpn * PageSize != addr)
+	return -1;
+    frameTable->lock->Acquire();
+    region->file->Unmap(this, region->firstVpn);
+    region->file = NULL;
+    frameTable->lock->Release();
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Sbrk
+// 	Grow or shrink the heap, by moving the break.  New pages are
+//	zero-filled on their first fault; the pages given back are thrown
+//	away, so they are zeroes again if the heap grows back over them.
+//	Returns the old break, or -1 if the heap would run into the stack
+//	or shrink below its start.
+//
+//	"delta" is the number of bytes to add, or remove if negative
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Sbrk(int delta)
+{
+    int old = brk;
+
+    frameTable->lock->Acquire();
+    if (brk + delta < heapStart ||
+	    divRoundUp(brk + delta, PageSize) > stackBottom) {
+	frameTable->lock->Release();
+	return -1;
+    }
+    brk += delta;
+    for (int vpn = divRoundUp(brk, PageSize); vpn < divRoundUp(old, PageSize);
+	    vpn++)
+	Discard(vpn);
+    frameTable->lock->Release();
+    DEBUG('a', "Break moved from 0x%x to 0x%x\n", old, brk);
+    return old;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ValidFault
+// 	Decide whether a page fault at an address is a program error.
+//	Everything in the address space may be touched, except the part
+//	of the gap between the heap and the main stack that neither has
+//	grown into.  A fault in the gap at or above the stack pointer is
+//	the stack growing: it now extends down to the faulting page,
+//	whose pages are zero-filled when touched.  Past the main stack,
+//	only the pages of a live mapping or of a thread's stack are valid.
+//
+//	"addr" is the faulting virtual address
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::ValidFault(int addr)
+{
+    int vpn = (unsigned) addr / PageSize;
+    bool valid;
+
+    if (addr < 0 || vpn >= (int) numPages)
+	return FALSE;
+    if (vpn >= stackEnd) {		// an unmapped file, or a hole
+	frameTable->lock->Acquire();
+	valid = FindRegion(vpn) != NULL || InThreadStack(vpn);
+	frameTable->lock->Release();
+	return valid;
+    }
+    if (vpn < divRoundUp(brk, PageSize) || vpn >= stackBottom)
+	return TRUE;
+    if (addr < machine->ReadRegister(StackReg))
+	return FALSE;
+    frameTable->lock->Acquire();
+    if (vpn < stackBottom && vpn >= divRoundUp(brk, PageSize)) {
+	DEBUG('a', "Stack grows down to vpn %d\n", vpn);
+	stackBottom = vpn;
+    }
+    frameTable->lock->Release();
+    return vpn >= stackBottom;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Discard
+// 	Throw away the contents of a page the program gave back: free its
+//	frame, and forget its copy in the swap file.  A frame the pager is
+//	writing out is left to it, but can no longer be reclaimed.
+//
+//	The caller must hold frameTable->lock.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Discard(int vpn)
+{
+    TranslationEntry *entry = pageTable->Lookup(vpn);
+
+    if (entry == NULL)
+	return;
+    if (entry->valid) {
+	Unmap(vpn);
+	frameTable->FreeFrame(entry->physicalPage);
+    }
+    entry->physicalPage = -1;
+    onDisk->Clear(vpn);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocateStack
+// 	Find a stack for a new thread of the program, of UserStackSize
+//	bytes.  The stack of a thread that has exited is reused; otherwise
+//	new pages are added to the address space, which are zero-filled
+//	when first touched.  Returns the initial stack pointer, or -1 if
+//	the program has too many threads.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AllocateStack()
+{
+    int pages = divRoundUp(UserStackSize, PageSize);
+
+    for (int s = 0; s < MaxThreadStacks; s++) {
+	if (stackInUse[s])
+	    continue;
+	if (stackVpn[s] == -1) {
+	    frameTable->lock->Acquire();
+	    stackVpn[s] = AllocateRegion(pages);
+	    frameTable->lock->Release();
+	}
+	stackInUse[s] = TRUE;
+	DEBUG('a', "Thread stack at vpn %d\n", stackVpn[s]);
+	return (stackVpn[s] + pages) * PageSize - 16;
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FreeStack
+// 	A thread is done with the stack AllocateStack gave it; keep its
+//	pages for the next thread.
+//
+//	"stackReg" is the stack pointer AllocateStack returned
+//----------------------------------------------------------------------
+
+void
+AddrSpace::FreeStack(int stackReg)
+{
+    int pages = divRoundUp(UserStackSize, PageSize);
+
+    for (int s = 0; s < MaxThreadStacks; s++)
+	if (stackInUse[s] &&
+		(stackVpn[s] + pages) * PageSize - 16 == stackReg) {
+	    stackInUse[s] = FALSE;
+	    return;
+	}
+    ASSERT(FALSE);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InThreadStack
+// 	Is a virtual page part of the stack of a running thread?
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::InThreadStack(int vpn)
+{
+    int pages = divRoundUp(UserStackSize, PageSize);
+
+    for (int s = 0; s < MaxThreadStacks; s++)
+	if (stackInUse[s] && vpn >= stackVpn[s] && vpn < stackVpn[s] + pages)
+	    return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FindRegion
+// 	Return the mapped region holding a virtual page, or NULL.
+//----------------------------------------------------------------------
+
+MapRegion *
+AddrSpace::FindRegion(int vpn)
+{
+    for (int r = 0; r < MaxMappings; r++)
+	if (regions[r].file != NULL && vpn >= regions[r].firstVpn &&
+		vpn < regions[r].firstVpn + regions[r].numPages)
+	    return &regions[r];
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocateRegion
+// 	Extend the address space by some pages, and return the first of
+//	them.  The page table and the map of pages in the swap file grow
+//	with it.  If we are running, tell the machine the page table grew.
+//
+//	The caller must hold frameTable->lock.
+//
+//	"count" is the number of pages to add
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AllocateRegion(int count)
+{
+    int first = numPages;
+    BitMap *grown = new BitMap(numPages + count);
+
+    for (int vpn = 0; vpn < first; vpn++)
+	if (onDisk->Test(vpn))
+	    grown->Mark(vpn);
+    delete onDisk;
+    onDisk = grown;
+
+    numPages += count;
+    pageTable->Grow(numPages);
+    if (machine->pageTable == pageTable)
+	machine->pageTableSize = numPages;
+    if (smp != NULL)
+	for (int c = 0; c < smp->NumCpus(); c++)
+	    if (smp->GetCpu(c)->pageTable == pageTable)
+		smp->GetCpu(c)->pageTableSize = numPages;
+    return first;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SyncTLB
+// 	Fold the use and dirty bits the hardware set in the TLB back into
+//	the page table, so that page replacement sees them.  The TLB use
+//	bits are cleared so the next sweep of the clock sees fresh ones.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::SyncTLB()
+{
+    TranslationEntry *entry;
+
+    if (machine->tlb == NULL)
+	return;
+    for (int i = 0; i < TLBSize; i++) {
+	if (!machine->tlb[i].valid)
+	    continue;
+	entry = pageTable->Lookup(machine->tlb[i].virtualPage);
+	if (entry == NULL || !entry->valid)
+	    continue;
+	if (machine->tlb[i].use)
+	    entry->use = TRUE;
+	if (machine->tlb[i].dirty)
+	    entry->dirty = TRUE;
+	machine->tlb[i].use = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::UserToPhys
+// 	Translate a user virtual address for the kernel, the way the
+//	hardware would, except that a page fault is handled here and the
+//	translation retried, instead of being left to the user program.
+//	Returns -1 if the address is outside the address space, or if
+//	"writing" and the page is read-only.
+//
+//	The space must be the one running (its page table is loaded).
+//----------------------------------------------------------------------
+
+int
+AddrSpace::UserToPhys(int addr, bool writing)
+{
+    int physAddr;
+    ExceptionType exception;
+
+    if (!ValidFault(addr))
+	return -1;
+    for (;;) {
+	exception = machine->Translate(addr, &physAddr, 1, writing);
+	if (exception == NoException)
+	    return physAddr;
+	if (exception != PageFaultException)
+	    return -1;
+	machine->WriteRegister(BadVAddrReg, addr);
+	ExceptionHandler(PageFaultException);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyIn
+// 	Copy the arguments of a system call from user memory into a
+//	kernel buffer, a page at a time.
+//
+//	"addr" is the user virtual address to copy from
+//	"buffer", "size" are where to copy to, and how many bytes
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyIn(int addr, char *buffer, int size)
+{
+    int physAddr, count;
+
+    while (size > 0) {
+	if ((physAddr = UserToPhys(addr, FALSE)) == -1)
+	    return FALSE;
+	count = min(size, PageSize - addr % PageSize);
+	bcopy(&machine->mainMemory[physAddr], buffer, count);
+	addr += count;
+	buffer += count;
+	size -= count;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOut
+// 	Copy the results of a system call from a kernel buffer into user
+//	memory, a page at a time.
+//
+//	"addr" is the user virtual address to copy to
+//	"buffer", "size" are where to copy from, and how many bytes
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyOut(int addr, char *buffer, int size)
+{
+    int physAddr, count;
+
+    while (size > 0) {
+	if ((physAddr = UserToPhys(addr, TRUE)) == -1)
+	    return FALSE;
+	count = min(size, PageSize - addr % PageSize);
+	bcopy(buffer, &machine->mainMemory[physAddr], count);
+	addr += count;
+	buffer += count;
+	size -= count;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReadString
+// 	Copy a null-terminated string, such as a file name, from user
+//	memory.  Returns its length, or -1 if the address is bad or the
+//	string does not fit in the buffer.
+//
+//	"addr" is the user virtual address of the string
+//	"buffer", "size" are where to copy it to, and the buffer size
+//----------------------------------------------------------------------
+
+int
+AddrSpace::ReadString(int addr, char *buffer, int size)
+{
+    int physAddr;
+
+    for (int i = 0; i < size; i++) {
+	if ((physAddr = UserToPhys(addr + i, FALSE)) == -1)
+	    return -1;
+	buffer[i] = machine->mainMemory[physAddr];
+	if (buffer[i] == '\0')
+	    return i;
+    }
+    return -1;
 }
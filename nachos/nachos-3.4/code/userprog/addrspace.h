@@ -15,8 +15,29 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "pagetable.h"
+#include "bitmap.h"
+#include "sharedtext.h"
+#include "mappedfile.h"
+#include "execimage.h"
 
-#define UserStackSize		1024 	// increase this as necessary!
+#define UserStackSize		1024 	// initial size of a stack
+#define UserGrowSize		(64 * 1024)
+					// room left between the heap and
+					// the main stack for them to grow
+#define MaxMappings		8	// mapped files per address space
+#define MaxThreadStacks		16	// stacks for threads created by
+					// ThreadCreate, per address space
+
+// A region of the address space where a file is mapped.
+
+class MapRegion {
+  public:
+    int firstVpn;			// first virtual page of the region
+    int numPages;			// size of the region, in pages
+    int firstPage;			// first file page mapped
+    MappedFile *file;			// NULL if the slot is unused
+};
 
 class AddrSpace {
   public:
@@ -31,11 +52,102 @@ class AddrSpace {
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
 
+    TranslationEntry *PageEntry(int vpn) { return pageTable->Lookup(vpn); }
+					// Translation entry of "vpn", NULL
+					// if it has never been touched
+    unsigned int NumPages() { return numPages; }
+
+    void PageIn(int vpn);		// Load "vpn" into a physical frame,
+					// on a page fault
+    void PageOut(int vpn);		// Evict "vpn", writing it back to
+					// the swap file if it is dirty
+    bool Unmap(int vpn);		// Invalidate "vpn"; return TRUE
+					// if it needs writing back
+    void WriteSwap(int vpn, int *frames, int count);
+					// Write "count" pages, starting at
+					// "vpn", to the swap file at once
+    void SyncTLB();			// Copy the use/dirty bits of the TLB
+					// back into the page table
+
+    int Mmap(OpenFile *file, int offset, int length);
+					// Map part of a file; return its
+					// virtual address, or -1
+    int Munmap(int addr);		// Remove the mapping at "addr";
+					// return 0, or -1 if there is none
+
+    int Sbrk(int delta);		// Move the break; return the old
+					// one, or -1 if there is no room
+    bool ValidFault(int addr);		// May "addr" be paged in?  Grows
+					// the main stack down to it if it
+					// is just below
+
+    int AllocateStack();		// Stack for a new thread; return
+					// its initial stack pointer, or -1
+    void FreeStack(int stackReg);	// The thread using it is done
+
+    bool CopyIn(int addr, char *buffer, int size);
+					// Copy user memory into the kernel;
+					// FALSE if "addr" is bad
+    bool CopyOut(int addr, char *buffer, int size);
+					// Copy kernel data to user memory
+    int ReadString(int addr, char *buffer, int size);
+					// Copy in a null-terminated string of
+					// at most "size" - 1 characters;
+					// return its length, or -1
+
+    void AddRef() { refCount++; }	// Another thread shares the space
+    int DropRef() { return --refCount; } // A thread is done with it;
+					// returns the number of users left
+
+// Working set accounting, maintained by the frame table (frametable.cc)
+    int workingSet;			// Estimated number of frames needed
+    int lastFault;			// stats->totalTicks at the last fault
+    bool suspended;			// Swapped out until memory frees up
+    bool justResumed;			// Admit the next fault unconditionally
+    int sampled;			// Scratch, for SampleReferences
+
   private:
-    TranslationEntry *pageTable;	// Assume linear page table translation
-					// for now!
+    PageTable *pageTable;		// Two-level page table, sized for
+					// the whole virtual address space
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    OpenFile *swapFile;			// Backing store: page "vpn" lives
+					// at offset vpn * PageSize
+    char swapName[32];			// Name of the swap file
+    BitMap *onDisk;			// Pages with a copy in the swap
+					// file; the others come from the
+					// image, or are zero-filled.
+					// Replaced when the space grows
+    ExecImage *image;			// The cached executable
+    SharedText *text;			// Code pages shared with the other
+					// processes running the program,
+					// NULL if none
+    bool IsText(int vpn) { return text != NULL && text->Contains(vpn); }
+    MapRegion regions[MaxMappings];	// Mapped files
+    MapRegion *FindRegion(int vpn);	// Region holding "vpn", or NULL
+    int AllocateRegion(int count);	// Add "count" pages at the end of
+					// the address space; return the
+					// first one
+    int heapStart;			// First address of the heap
+    int brk;				// Current end of the heap
+    int stackBottom;			// Lowest page of the main stack
+    int stackEnd;			// First page past the main stack;
+					// thread stacks and mapped files
+					// are added from there
+    void Discard(int vpn);		// Throw away the contents of "vpn"
+    int stackVpn[MaxThreadStacks];	// First page of each thread stack,
+					// -1 if not allocated yet
+    bool stackInUse[MaxThreadStacks];
+    bool InThreadStack(int vpn);	// Is "vpn" in a running thread's
+					// stack?
+    int UserToPhys(int addr, bool writing);
+					// Physical address of "addr", paging
+					// it in if needed; -1 if bad
+
+    int refCount;			// Number of threads using the space
+
+    static int nextSpaceId;		// Used to give each swap file a
+					// distinct name
 };
 
 #endif // ADDRSPACE_H
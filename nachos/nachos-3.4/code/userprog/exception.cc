@@ -4,8 +4,11 @@
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel.  System calls are dispatched through a table
+//	indexed by the system call code (see syscall.h); each entry names
+//	a handler, the number of arguments it takes, and whether it
+//	returns a result.  Every call is counted, and the time it takes
+//	recorded, in the statistics.
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
@@ -14,8 +17,7 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// Page faults are handled here too.  Everything else core dumps.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -33,8 +35,9 @@
 #include "filesys.h"
 #include "filehdr.h"
 #include "openfile.h"
+#include "synchconsole.h"
 
-#define LRU
+#define MaxStringLength	128	// longest file name a user can pass in
 
 void exec_func(int name) {
     char *filename = (char*) name;
@@ -43,8 +46,11 @@ void exec_func(int name) {
 
     if (executable == NULL) {
         printf("Unable to open file %s\n", filename);
+        delete [] filename;
+        processTable->Exit(currentThread->process, -1);
         return;
     }
+    delete [] filename;
     space = new AddrSpace(executable);    
     currentThread->space = space;
 
@@ -53,7 +59,7 @@ void exec_func(int name) {
     space->InitRegisters();		// set the initial register values
     space->RestoreState();		// load page table register
 
-    printf("Exec thread is running...\n");
+    DEBUG('c', "Exec thread is running\n");
     machine->Run();			// jump to the user progam
 }
 
@@ -61,380 +67,982 @@ class ThreadState {
     public:
     int pc;
     AddrSpace* space;
+    int arg;				// for ThreadCreate: argument, stack
+    int stack;				// pointer, and where to return to
+    int retAddr;			// when the procedure is done
 };
 
 void fork_func(int s) {
     ThreadState* state = (ThreadState*) s;
-    AddrSpace* tmp = state->space;
-    AddrSpace* space = new AddrSpace(*tmp);
-    currentThread->space = space;
+    AddrSpace* space = state->space;	// shared with the parent, which
+    currentThread->space = space;	// counted us as a user
 
     int cur_pc = state->pc;
+    delete state;
     machine->WriteRegister(PCReg, cur_pc);
     machine->WriteRegister(NextPCReg, cur_pc + 4);
 
     currentThread->SaveUserState();
-    printf("Prepare to run the fork thread\n");
+    DEBUG('c', "Prepare to run the fork thread\n");
     machine->Run();
 }
 
+//----------------------------------------------------------------------
+// user_thread_func
+// 	Start a thread made by ThreadCreate: call the user procedure on
+//	the thread's own stack, returning to the ThreadExit stub.  The
+//	address space already counts the thread as a user.
+//----------------------------------------------------------------------
+
+void user_thread_func(int s) {
+    ThreadState* state = (ThreadState*) s;
+
+    currentThread->space = state->space;
+    for (int i = 0; i < NumTotalRegs; i++)
+        machine->WriteRegister(i, 0);
+    machine->WriteRegister(PCReg, state->pc);
+    machine->WriteRegister(NextPCReg, state->pc + 4);
+    machine->WriteRegister(4, state->arg);
+    machine->WriteRegister(StackReg, state->stack);
+    machine->WriteRegister(RetAddrReg, state->retAddr);
+    delete state;
+
+    currentThread->space->RestoreState();
+    DEBUG('c', "User thread %d is running\n", currentThread->getTid());
+    machine->Run();
+}
 
 //----------------------------------------------------------------------
-// ExceptionHandler
-// 	Entry point into the Nachos kernel.  Called when a user program
-//	is executing, and either does a syscall, or generates an addressing
-//	or arithmetic exception.
-//
-// 	For system calls, the following is the calling convention:
-//
-// 	system call code -- r2
-//		arg1 -- r4
-//		arg2 -- r5
-//		arg3 -- r6
-//		arg4 -- r7
+// EndThread
+// 	The current thread is leaving user mode for good, by Exit or
+//	ThreadExit: give back its stack and its hold on the address
+//	space, and end the process if it is the last thread.  When the
+//	first program is over, Nachos halts.
 //
-//	The result of the system call, if any, must be put back into r2. 
-//
-// And don't forget to increment the pc before returning. (Or else you'll
-// loop making the same system call forever!
+//	"exit" is TRUE for Exit, with exit status "status"
+//----------------------------------------------------------------------
+
+static void
+EndThread(bool exit, int status)
+{
+    Process* process = currentThread->process;
+    AddrSpace* space = currentThread->space;
+    bool over;
+
+    currentThread->inSyscall = FALSE;
+    if (currentThread->userStack != -1) {
+        space->FreeStack(currentThread->userStack);
+    }
+    currentThread->space = NULL;
+    currentThread->process = NULL;
+    if (space->DropRef() == 0) {
+        delete space;			// frees its frames for the others
+    }
+    if (exit) {
+        over = processTable->Exit(process, status);
+    }
+    else {
+        over = processTable->ThreadExit(process);
+    }
+    if (over) {
+        DEBUG('c', "Initial process is over\n");
+        interrupt->Halt();
+    }
+    currentThread->Finish();
+}
+
+//----------------------------------------------------------------------
+// activation_func
+// 	Start an activation made by BlockedInSyscall: find it a stack,
+//	and make the upcall on it.
+//----------------------------------------------------------------------
+
+void activation_func(int s) {
+    ThreadState* state = (ThreadState*) s;
+
+    currentThread->space = state->space;
+    state->stack = state->space->AllocateStack();
+    if (state->stack == -1) {
+        DEBUG('c', "No stack for the upcall\n");
+        delete state;
+        EndThread(FALSE, 0);
+    }
+    currentThread->userStack = state->stack;
+    user_thread_func((int) state);
+}
+
+//----------------------------------------------------------------------
+// BlockedInSyscall
+// 	A thread of a process that asked for upcalls is about to block in
+//	a system call.  Give the process a fresh activation -- a thread
+//	that calls its upcall procedure, with the identifier of the thread
+//	that blocked -- so that its user-level scheduler can run another
+//	of its user threads meanwhile.  The blocked thread carries on
+//	with its system call, and then with the user code that made it.
 //
-//	"which" is the kind of exception.  The list of possible exceptions 
-//	are in machine.h.
+//	One upcall is made per system call, however many times it blocks.
+//	Called by Thread::Sleep, with interrupts off: nothing here may
+//	block, so the stack is found by the activation itself.
 //----------------------------------------------------------------------
 
 void
-ExceptionHandler(ExceptionType which)
+BlockedInSyscall(Thread *thread)
 {
-    int type = machine->ReadRegister(2);
+    Process* process = thread->process;
+    Thread* activation;
+    ThreadState* state;
 
-    if ((which == SyscallException) && (type == SC_Halt)) {
-        DEBUG('a', "Shutdown, initiated by user program.\n");
-        interrupt->Halt();
+    thread->inSyscall = FALSE;
+    if (process == NULL || process->upcall == -1) {
+        return;
+    }
+    activation = Thread::createThread("activation");
+    if (activation == NULL) {
+        return;
     }
+    state = new ThreadState;
+    state->pc = process->upcall;
+    state->space = thread->space;
+    state->arg = thread->getTid();
+    state->retAddr = process->upcallExit;
 
-    else if ((which == SyscallException) && (type == SC_Create)) {
-        int name_pos = machine->ReadRegister(4);
-        int v;
-        int name_len = 0;
-        char name[name_len + 1];
-        int i = 0;
-        while (1) {
-            machine->ReadMem(name_pos, 1, &v);
-            name_pos++;
-            name_len++;
-            if (v == 0) break;
-            else {
-                name[i] = (char)v;
-                i++;
-            }
-        }
-        name[name_len] = '\0';
-        printf("Creating file: %s\n", name);
-        fileSystem->Create(name, 0);
-        printf("Creating success!\n");
-        machine->PCAdvance();
-    }
-
-    else if ((which == SyscallException) && (type == SC_Open)) {
-        int name_pos = machine->ReadRegister(4);
-        int v;
-        int name_len = 0;
-        char name[name_len + 1];
-        int i = 0;
-        while (1) {
-            machine->ReadMem(name_pos, 1, &v);
-            name_pos++;
-            name_len++;
-            if (v == 0) break;
-            else {
-                name[i] = (char)v;
-                i++;
-            }
-        }
-        name[name_len] = '\0';
-        printf("Opening file: %s\n", name);
-        OpenFile *openfile = fileSystem->Open(name);
-        if (openfile == NULL) {
-            printf("Open file failed, file name: %s\n", name);
+    thread->space->AddRef();
+    process->numThreads++;		// safe with interrupts off: the
+					// blocked thread keeps it above 0
+    activation->process = process;
+    DEBUG('c', "Upcall for blocked thread %d\n", thread->getTid());
+    activation->Fork(activation_func, (int)state);
+}
+
+//----------------------------------------------------------------------
+// UserConsole
+// 	Return the console that ConsoleInput and ConsoleOutput refer to.
+//	It is started the first time a program uses it, since the device
+//	keeps polling the keyboard from then on.
+//----------------------------------------------------------------------
+
+static SynchConsole *synchConsole = NULL;
+
+static SynchConsole *
+UserConsole()
+{
+    if (synchConsole == NULL) {
+        synchConsole = new SynchConsole(NULL, NULL);
+    }
+    return synchConsole;
+}
+
+//----------------------------------------------------------------------
+// NewProcess
+// 	Make a thread to run a new process, a child of the current one.
+//	Returns NULL if there are too many threads already.
+//----------------------------------------------------------------------
+
+static Thread *
+NewProcess()
+{
+    Thread* new_thread = Thread::createThread("new thread");
+
+    if (new_thread != NULL) {
+        new_thread->process = processTable->Create(currentThread->process);
+    }
+    return new_thread;
+}
+
+//----------------------------------------------------------------------
+// System call handlers.  Each is called with the four argument
+// registers, r4 to r7, and returns the result of the call, which is
+// put in r2 if the system call has one.  The pc is advanced after
+// the handler returns, so a handler that yields the CPU resumes the
+// user program at the right place.
+//----------------------------------------------------------------------
+
+static int
+SysHalt(int, int, int, int)
+{
+    DEBUG('a', "Shutdown, initiated by user program.\n");
+    interrupt->Halt();
+    return 0;
+}
+
+static int
+SysExit(int status, int, int, int)
+{
+    EndThread(TRUE, status);
+    return 0;
+}
+
+static int
+SysExec(int namePos, int, int, int)
+{
+    char *name = new char[MaxStringLength];
+    Thread* new_thread;
+    int pid;
+
+    if (currentThread->space->ReadString(namePos, name, MaxStringLength) < 0
+            || (new_thread = NewProcess()) == NULL) {
+        DEBUG('c', "Exec fail!\n");
+        delete [] name;
+        return 0;
+    }
+    pid = new_thread->process->pid;	// the child may be gone by the
+					// time we run again
+    new_thread->Fork(exec_func, (int)name);	// exec_func frees "name"
+    currentThread->Yield();
+    return pid;
+}
+
+static int
+SysJoin(int pid, int, int, int)
+{
+    int status = processTable->Join(currentThread->process, pid);
+
+    DEBUG('c', "Joined process %d, status %d\n", pid, status);
+    return status;
+}
+
+static int
+SysCreate(int namePos, int, int, int)
+{
+    char name[MaxStringLength];
+    OpenFile *file;
+
+    if (currentThread->space->ReadString(namePos, name, MaxStringLength) < 0)
+        return 0;
+    DEBUG('c', "Creating file: %s\n", name);
+    fileSystem->Create(name, 0);
+    if ((file = fileSystem->Open(name)) != NULL) {
+        imageCache->Invalidate(file->HeaderSector());	// may be new
+        delete file;
+    }
+    return 0;
+}
+
+static int
+SysOpen(int namePos, int, int, int)
+{
+    char name[MaxStringLength];
+    OpenFile *openfile;
+
+    int fd;
+
+    if (currentThread->space->ReadString(namePos, name, MaxStringLength) < 0)
+        return -1;
+    DEBUG('c', "Opening file: %s\n", name);
+    openfile = fileSystem->Open(name);
+    if (openfile == NULL) {
+        DEBUG('c', "Open file failed, file name: %s\n", name);
+        return -1;
+    }
+    fd = processTable->AddDescriptor(currentThread->process, openfile,
+        NULL, FALSE);
+    if (fd == -1) {
+        delete openfile;
+    }
+    return fd;
+}
+
+//----------------------------------------------------------------------
+// SysRead, SysWrite
+// 	Move data between a user buffer and a file or the console a page
+//	at a time, through a buffer on the kernel stack, however big a
+//	transfer the user asks for.  (A console line fits in one page, so
+//	a console Read is one chunk; a console Write bigger than a page
+//	may be interleaved with other writers between chunks.)
+//----------------------------------------------------------------------
+
+static int
+SysRead(int buff, int size, int id, int)
+{
+    Descriptor* descriptor =
+        processTable->FindDescriptor(currentThread->process, id);
+    char chunk[PageSize];
+    int numRead, piece, count;
+
+    if (descriptor == NULL && id == ConsoleInput && size >= 0) {
+        numRead = UserConsole()->Read(chunk, min(size, PageSize));
+        if (!currentThread->space->CopyOut(buff, chunk, numRead))
+            numRead = -1;
+        return numRead;
+    }
+    if (descriptor == NULL || size < 0) {
+        DEBUG('c', "File not exist\n");
+        return -1;
+    }
+    if (descriptor->pipe != NULL) {
+        if (descriptor->writeEnd) {
+            return -1;
         }
-        else {
-            machine->WriteRegister(2, (int)openfile);
-            printf("Open success!\n");
+        return descriptor->pipe->Read(currentThread->space, buff, size);
+    }
+    for (numRead = 0; numRead < size; numRead += count) {
+        piece = min(size - numRead, PageSize);
+        count = descriptor->file->Read(chunk, piece);
+        if (!currentThread->space->CopyOut(buff + numRead, chunk, count))
+            return -1;
+        if (count < piece) {		// end of file
+            numRead += count;
+            break;
         }
-        machine->PCAdvance();
     }
+    DEBUG('c', "Read %d bytes from file %d\n", numRead, id);
+    return numRead;
+}
 
-    else if ((which == SyscallException) && (type == SC_Read)) {
-        int buff = machine->ReadRegister(4);
-        int size = machine->ReadRegister(5);
-        int id = machine->ReadRegister(6);
+static int
+SysWrite(int buff, int size, int id, int)
+{
+    Descriptor* descriptor =
+        processTable->FindDescriptor(currentThread->process, id);
+    char chunk[PageSize];
+    int done, piece;
 
-        OpenFile* tmpfile = (OpenFile*) id;
-        if (tmpfile == NULL) {
-            printf("File not exist\n");
+    if (descriptor == NULL && id == ConsoleOutput && size >= 0) {
+        for (done = 0; done < size; done += piece) {
+            piece = min(size - done, PageSize);
+            if (!currentThread->space->CopyIn(buff + done, chunk, piece))
+                break;
+            UserConsole()->Write(chunk, piece);
         }
-        else {
-            printf("Begin reading...\n");
-            char tmp_buffer[size];
-            int tmp, i;
-            tmpfile->Read(tmp_buffer, size);
-            tmp_buffer[size] = '\0';
-            for (i = 0; i < size; i++) {
-                tmp = (int)tmp_buffer[i];
-                machine->WriteMem(buff + i, 1, tmp);
-            }
-            machine->WriteRegister(2, i);
-            printf("Read success. Content is %s\n", tmp_buffer);
+        return 0;
+    }
+    if (descriptor == NULL || size < 0) {
+        DEBUG('c', "File not exist\n");
+        return 0;
+    }
+    if (descriptor->pipe != NULL) {
+        if (descriptor->writeEnd) {
+            descriptor->pipe->Write(currentThread->space, buff, size);
         }
-        machine->PCAdvance();
+        return 0;
+    }
+    for (done = 0; done < size; done += piece) {
+        piece = min(size - done, PageSize);
+        if (!currentThread->space->CopyIn(buff + done, chunk, piece))
+            break;
+        descriptor->file->Write(chunk, piece);
+    }
+    if (done > 0) {
+        imageCache->Invalidate(descriptor->file->HeaderSector());
     }
+    DEBUG('c', "Wrote %d bytes to file %d\n", done, id);
+    return 0;
+}
 
-    else if ((which == SyscallException) && (type == SC_Write)) {
-        int buff = machine->ReadRegister(4);
-        int size = machine->ReadRegister(5);
-        int id = machine->ReadRegister(6);
+static int
+SysClose(int id, int, int, int)
+{
+    if (processTable->Close(currentThread->process, id) == -1) {
+        DEBUG('c', "Cannot close file\n");
+    }
+    return 0;
+}
 
-        char tmp_buffer[size];
-        int tmp;
-        for (int i = 0; i < size; i++) {
-            machine->ReadMem(buff + i, 1, &tmp);
-            tmp_buffer[i] = (char)tmp;
-        }
+static int
+SysPipe(int fdsPos, int, int, int)
+{
+    Process* process = currentThread->process;
+    PipeBuffer* pipe = new PipeBuffer;
+    int readFd, writeFd, fds[2];
 
-        OpenFile* tmpfile = (OpenFile*) id;
-        
-        if (tmpfile == NULL) {
-            printf("File not exist\n");
+    readFd = processTable->AddDescriptor(process, NULL, pipe, FALSE);
+    writeFd = processTable->AddDescriptor(process, NULL, pipe, TRUE);
+    if (readFd != -1 && writeFd != -1) {
+        fds[0] = WordToMachine(readFd);
+        fds[1] = WordToMachine(writeFd);
+        if (currentThread->space->CopyOut(fdsPos, (char *) fds,
+                sizeof(fds))) {
+            DEBUG('c', "Pipe from %d to %d\n", writeFd, readFd);
+            return 0;
         }
-        else {
-            printf("Begin writing...\n");
-            tmpfile->Write(tmp_buffer, size);
-            printf("Write success. Content is %s\n", tmp_buffer);
-        }
-        machine->PCAdvance();
     }
 
-    else if ((which == SyscallException) && (type == SC_Close)) {
-        int file = machine->ReadRegister(4);
-        OpenFile* tmpfile = (OpenFile*) file;
-        if (tmpfile == NULL) {
-            printf("Cannot close file\n");
-        }
-        else {
-            delete tmpfile;
-            printf("Close file success!\n");
-        }
-        machine->PCAdvance();
-    }
-
-    else if ((which == SyscallException) && (type == SC_Exec)) {
-        int name_pos = machine->ReadRegister(4);
-        int v;
-        int name_len = 0;
-        char name[name_len + 1];
-        int i = 0;
-        while (1) {
-            machine->ReadMem(name_pos, 1, &v);
-            //printf("hhhh %c\n", (char)v);
-            name_pos++;
-            //name_len++;
-            if ((char)v == '\0') break;
-            else {
-                name[i] = (char)v;
-                i++;
-            }
+    // undo what we did; closing both ends deletes the pipe
+    if (readFd != -1) {
+        processTable->Close(process, readFd);
+    }
+    else {
+        pipe->Close(FALSE);
+    }
+    if (writeFd != -1) {
+        processTable->Close(process, writeFd);
+    }
+    else if (pipe->Close(TRUE)) {
+        delete pipe;
+    }
+    return -1;
+}
+
+static int
+SysFork(int pc, int, int, int)
+{
+    Thread* new_thread = NewProcess();
+    ThreadState* state;
+    int pid;
+
+    if (new_thread == NULL) {
+        DEBUG('c', "Fork fail!\n");
+        return 0;
+    }
+    state = new ThreadState;
+    state->pc = pc;
+    state->space = currentThread->space;
+    state->space->AddRef();		// the child shares our memory
+    DEBUG('c', "Fork a new thread\n");
+    pid = new_thread->process->pid;
+    new_thread->Fork(fork_func, (int)state);
+    currentThread->Yield();
+    return pid;
+}
+
+static int
+SysYield(int, int, int, int)
+{
+    currentThread->Yield();
+    return 0;
+}
+
+static int
+SysMmap(int id, int offset, int length, int)
+{
+    Descriptor* descriptor =
+        processTable->FindDescriptor(currentThread->process, id);
+
+    if (descriptor == NULL || descriptor->file == NULL) {
+        return -1;
+    }
+    return currentThread->space->Mmap(descriptor->file, offset, length);
+}
+
+static int
+SysMunmap(int addr, int, int, int)
+{
+    return currentThread->space->Munmap(addr);
+}
+
+static int
+SysSbrk(int delta, int, int, int)
+{
+    return currentThread->space->Sbrk(delta);
+}
+
+static int
+SysThreadCreate(int func, int arg, int exitStub, int)
+{
+    AddrSpace* space = currentThread->space;
+    int stack = space->AllocateStack();
+    Thread* new_thread = NULL;
+    ThreadState* state;
+
+    if (stack != -1) {
+        new_thread = Thread::createThread("user thread");
+    }
+    if (new_thread == NULL) {
+        DEBUG('c', "ThreadCreate fail!\n");
+        if (stack != -1) {
+            space->FreeStack(stack);
         }
-        name[i] = '\0';
-        //printf("name: %s\n", name);
-
-        Thread* new_thread = new Thread("new thread");
-        for (i = 0; i < 10; i++) {
-            if (currentThread->child[i] == NULL) {
-                currentThread->child[i] = new_thread;
-                machine->WriteRegister(2, (int)new_thread);
-                break;
-            }
-            if (i == 9 && currentThread->child != NULL) {
-                printf("Exec fail!\n");
-                machine->PCAdvance();
-                return;
-            }
+        return -1;
+    }
+    state = new ThreadState;
+    state->pc = func;
+    state->space = space;
+    state->arg = arg;
+    state->stack = stack;
+    state->retAddr = exitStub;
+
+    space->AddRef();
+    processTable->AddThread(currentThread->process);
+    new_thread->process = currentThread->process;
+    new_thread->userStack = stack;
+    new_thread->Fork(user_thread_func, (int)state);
+    return new_thread->getTid();
+}
+
+static int
+SysThreadExit(int, int, int, int)
+{
+    EndThread(FALSE, 0);
+    return 0;
+}
+
+static int
+SysUpcallSetup(int func, int exitStub, int, int)
+{
+    currentThread->process->upcall = func;
+    currentThread->process->upcallExit = exitStub;
+    return 0;
+}
+
+// User locks and condition variables are named by their index in
+// the tables of the process; these return NULL for a bad index.  A
+// lock that is held or waited for, or a condition some thread waits
+// on, cannot be destroyed.
+
+static Lock *
+UserLock(int id)
+{
+    if (id < 0 || id >= MaxUserLocks) {
+        return NULL;
+    }
+    return currentThread->process->locks[id];
+}
+
+static Condition *
+UserCond(int id)
+{
+    if (id < 0 || id >= MaxUserConds) {
+        return NULL;
+    }
+    return currentThread->process->conds[id];
+}
+
+static int
+SysLockCreate(int, int, int, int)
+{
+    Process* process = currentThread->process;
+
+    for (int id = 0; id < MaxUserLocks; id++) {
+        if (process->locks[id] == NULL) {
+            process->locks[id] = new Lock("user lock");
+            return id;
         }
-        new_thread->father = currentThread;
-        new_thread->Fork(exec_func, (int)name);
-        currentThread->Yield();
-        machine->PCAdvance();
-    }
-
-    else if ((which == SyscallException) && (type == SC_Fork)) {
-        int cur_pc = machine->ReadRegister(4);
-        ThreadState* state = new ThreadState;
-        state->pc = cur_pc;
-        state->space = currentThread->space;
-
-        Thread* new_thread = new Thread("new thread");
-        for (int i = 0; i < 10; i++) {
-            if (currentThread->child[i] == NULL) {
-                currentThread->child[i] = new_thread;
-                machine->WriteRegister(2, (int)new_thread);
-                break;
-            }
-            if (i == 9 && currentThread->child != NULL) {
-                printf("Fork fail!\n");
-                machine->PCAdvance();
-                return;
-            }
+    }
+    return -1;
+}
+
+static int
+SysLockDestroy(int id, int, int, int)
+{
+    Lock* lock = UserLock(id);
+    IntStatus oldLevel;
+
+    if (lock == NULL) {
+        return -1;
+    }
+    oldLevel = interrupt->SetLevel(IntOff);	// nobody may take it now
+    if (lock->IsBusy()) {
+        (void) interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    delete lock;
+    currentThread->process->locks[id] = NULL;
+    (void) interrupt->SetLevel(oldLevel);
+    return 0;
+}
+
+static int
+SysLockAcquire(int id, int, int, int)
+{
+    Lock* lock = UserLock(id);
+
+    if (lock == NULL) {
+        return -1;
+    }
+    lock->Acquire();
+    return 0;
+}
+
+static int
+SysLockRelease(int id, int, int, int)
+{
+    Lock* lock = UserLock(id);
+
+    if (lock == NULL || !lock->isHeldByCurrentThread()) {
+        return -1;
+    }
+    lock->Release();
+    return 0;
+}
+
+static int
+SysCondCreate(int, int, int, int)
+{
+    Process* process = currentThread->process;
+
+    for (int id = 0; id < MaxUserConds; id++) {
+        if (process->conds[id] == NULL) {
+            process->conds[id] = new Condition("user condition");
+            return id;
         }
-        new_thread->father = currentThread;
+    }
+    return -1;
+}
+
+static int
+SysCondDestroy(int id, int, int, int)
+{
+    Condition* cond = UserCond(id);
+    IntStatus oldLevel;
 
-        printf("Fork a new thread\n");
-        new_thread->Fork(fork_func, (int)state);
-        currentThread->Yield();
-        printf("I am main thread. I am back!\n");
-        machine->PCAdvance();
+    if (cond == NULL) {
+        return -1;
     }
+    oldLevel = interrupt->SetLevel(IntOff);	// nobody may wait on it now
+    if (cond->HasWaiters()) {
+        (void) interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    delete cond;
+    currentThread->process->conds[id] = NULL;
+    (void) interrupt->SetLevel(oldLevel);
+    return 0;
+}
 
-    else if ((which == SyscallException) && (type == SC_Yield)) {
-        machine->PCAdvance();
-        printf("I am yield\n");
-        currentThread->Yield();
+static int
+SysCondWait(int id, int lockId, int, int)
+{
+    Condition* cond = UserCond(id);
+    Lock* lock = UserLock(lockId);
+
+    if (cond == NULL || lock == NULL || !lock->isHeldByCurrentThread()) {
+        return -1;
     }
+    cond->Wait(lock);
+    return 0;
+}
 
-    else if ((which == SyscallException) && (type == SC_Join)) {
-        int id = machine->ReadRegister(4);
-        int i;
-        bool found;
+static int
+SysCondSignal(int id, int lockId, int, int)
+{
+    Condition* cond = UserCond(id);
+    Lock* lock = UserLock(lockId);
 
-        Thread* child = (Thread*) id;
-        for (i = 0; i < 10; i++) {
-            if (currentThread->child[i] == child) {
-                found = true;
-                break;
-            }
+    if (cond == NULL || lock == NULL || !lock->isHeldByCurrentThread()) {
+        return -1;
+    }
+    cond->Signal(lock);
+    return 0;
+}
+
+static int
+SysCondBroadcast(int id, int lockId, int, int)
+{
+    Condition* cond = UserCond(id);
+    Lock* lock = UserLock(lockId);
+
+    if (cond == NULL || lock == NULL || !lock->isHeldByCurrentThread()) {
+        return -1;
+    }
+    cond->Broadcast(lock);
+    return 0;
+}
+
+// Submission rings.  A program lays out a SyscallRing (syscall.h) in
+// its memory, registers it with RingSetup, queues requests in it, and
+// has them all carried out by one RingSubmit, which puts a completion
+// for each in the completion queue.  The ring is in the machine's
+// byte order, like all user data.
+
+static int RunHandler(int type, int *arg);
+
+#define RingRequestWords	5	// words in a RingRequest
+#define RingCompletionWords	2	// words in a RingCompletion
+#define RingHeaderWords		4	// sqHead, sqTail, cqHead, cqTail
+
+//----------------------------------------------------------------------
+// CopyWordsIn, CopyWordsOut
+// 	Copy words between user memory and the kernel, converting their
+//	byte order.
+//----------------------------------------------------------------------
+
+static bool
+CopyWordsIn(int addr, int *words, int count)
+{
+    if (!currentThread->space->CopyIn(addr, (char *) words,
+            count * sizeof(int)))
+        return FALSE;
+    for (int i = 0; i < count; i++)
+        words[i] = WordToHost(words[i]);
+    return TRUE;
+}
+
+static bool
+CopyWordsOut(int addr, int *words, int count)
+{
+    int buffer[RingRequestWords];
+
+    ASSERT(count <= RingRequestWords);
+    for (int i = 0; i < count; i++)
+        buffer[i] = WordToMachine(words[i]);
+    return currentThread->space->CopyOut(addr, (char *) buffer,
+        count * sizeof(int));
+}
+
+static int
+SysRingSetup(int ring, int, int, int)
+{
+    int header[RingHeaderWords];
+
+    if (ring % sizeof(int) != 0 || !CopyWordsIn(ring, header,
+            RingHeaderWords)) {
+        return -1;
+    }
+    currentThread->process->ring = ring;
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// SysRingSubmit
+// 	Carry out the requests queued in the submission ring, in order,
+//	for as long as there is room for their completions.  Only file
+//	operations may be queued; any other request completes with -1.
+//	Returns the number of requests carried out, or -1 if there is no
+//	ring.
+//----------------------------------------------------------------------
+
+static int
+SysRingSubmit(int, int, int, int)
+{
+    int ring = currentThread->process->ring;
+    int sq = ring + RingHeaderWords * sizeof(int);
+    int cq = sq + RingSize * RingRequestWords * sizeof(int);
+    int header[RingHeaderWords], request[RingRequestWords];
+    int completion[RingCompletionWords], arg[4];
+    int done = 0;
+
+    if (ring == -1 || !CopyWordsIn(ring, header, RingHeaderWords)) {
+        return -1;
+    }
+    // header: sqHead, sqTail, cqHead, cqTail
+    while (header[0] != header[1] && header[3] - header[2] < RingSize) {
+        if (!CopyWordsIn(sq + (header[0] & (RingSize - 1)) *
+                RingRequestWords * sizeof(int), request, RingRequestWords)) {
+            break;
         }
-        if (!found) {
-            printf("Cannot find thread\n");
-            machine->PCAdvance();
-            return;
+        completion[0] = request[4];		// userData
+        switch (request[0]) {
+          case SC_Create: case SC_Open: case SC_Read: case SC_Write:
+          case SC_Close:
+            arg[0] = request[1];
+            arg[1] = request[2];
+            arg[2] = request[3];
+            arg[3] = 0;
+            completion[1] = RunHandler(request[0], arg);
+            break;
+          default:
+            completion[1] = -1;
         }
-        while (currentThread->child[i] != NULL) {
-            //printf("I am waiting for my child %d\n", i);
-            currentThread->Yield();
+        if (!CopyWordsOut(cq + (header[3] & (RingSize - 1)) *
+                RingCompletionWords * sizeof(int), completion,
+                RingCompletionWords)) {
+            break;
         }
-        printf("My child is finished\n");
-        machine->PCAdvance();
+        header[0]++;
+        header[3]++;
+        done++;
+
+        // publish our progress, but leave the user's indices alone: other
+        // threads may queue requests, or take completions, meanwhile
+        CopyWordsOut(ring, &header[0], 1);
+        CopyWordsOut(ring + 3 * sizeof(int), &header[3], 1);
+        CopyWordsIn(ring + sizeof(int), &header[1], 2);
     }
+    DEBUG('c', "Ring submit carried out %d requests\n", done);
+    return done;
+}
 
-    else if ((which == SyscallException) && (type == SC_Exit)) {
-        /*
-        for (int i = 0; i < machine->pageTableSize; i++) {
-            if (machine->pageTable[i].valid == TRUE) {
-                int idx = machine->pageTable[i].physicalPage;
-                machine->bitmap->clear(idx);
-            }
-        }*/
-
-        //printf("TLB hits: %d\n", machine->TLBhit);
-        //printf("TLB miss: %d\n", machine->TLBmiss);
-        //float rate = (float)machine->TLBhit / (machine->TLBmiss + machine->TLBhit);
-        //printf("TLB hit rate: %f\n", rate);
-        //machine->end = 1;
-        if (currentThread->father == currentThread) {
-            machine->PCAdvance();
-        }
-        else {
-            Thread* father = currentThread->father;
-            for (int i = 0; i < 10; i++) {
-                if (father->child[i] == currentThread) {
-                    //printf("ssssssssssssss %d\n", i);
-                    father->child[i] = NULL;
-                    break;
-                }
-            }
-            currentThread->Finish();
-        }
-        //interrupt->Halt();
+// The system call table, indexed by system call code.
+
+typedef int (*SyscallHandler)(int arg1, int arg2, int arg3, int arg4);
+
+class SyscallEntry {
+  public:
+    int type;				// system call code, for checking
+    char *name;
+    int numArgs;			// arguments taken, from r4 up
+    bool hasResult;			// put the result in r2?
+    SyscallHandler handler;
+};
+
+static SyscallEntry syscallTable[] = {
+    { SC_Halt,	 "Halt",   0, FALSE, SysHalt },
+    { SC_Exit,	 "Exit",   1, FALSE, SysExit },
+    { SC_Exec,	 "Exec",   1, TRUE,  SysExec },
+    { SC_Join,	 "Join",   1, TRUE,  SysJoin },
+    { SC_Create, "Create", 1, FALSE, SysCreate },
+    { SC_Open,	 "Open",   1, TRUE,  SysOpen },
+    { SC_Read,	 "Read",   3, TRUE,  SysRead },
+    { SC_Write,	 "Write",  3, FALSE, SysWrite },
+    { SC_Close,	 "Close",  1, FALSE, SysClose },
+    { SC_Fork,	 "Fork",   1, TRUE,  SysFork },
+    { SC_Yield,	 "Yield",  0, FALSE, SysYield },
+    { SC_Mmap,	 "Mmap",   3, TRUE,  SysMmap },
+    { SC_Munmap, "Munmap", 1, TRUE,  SysMunmap },
+    { SC_ThreadCreate, "ThreadCreate", 3, TRUE, SysThreadCreate },
+    { SC_ThreadExit, "ThreadExit", 0, FALSE, SysThreadExit },
+    { SC_LockCreate, "LockCreate", 0, TRUE, SysLockCreate },
+    { SC_LockDestroy, "LockDestroy", 1, TRUE, SysLockDestroy },
+    { SC_LockAcquire, "LockAcquire", 1, TRUE, SysLockAcquire },
+    { SC_LockRelease, "LockRelease", 1, TRUE, SysLockRelease },
+    { SC_CondCreate, "CondCreate", 0, TRUE, SysCondCreate },
+    { SC_CondDestroy, "CondDestroy", 1, TRUE, SysCondDestroy },
+    { SC_CondWait, "CondWait", 2, TRUE, SysCondWait },
+    { SC_CondSignal, "CondSignal", 2, TRUE, SysCondSignal },
+    { SC_CondBroadcast, "CondBroadcast", 2, TRUE, SysCondBroadcast },
+    { SC_Pipe,	 "Pipe",   1, TRUE,  SysPipe },
+    { SC_RingSetup, "RingSetup", 1, TRUE, SysRingSetup },
+    { SC_RingSubmit, "RingSubmit", 0, TRUE, SysRingSubmit },
+    { SC_Sbrk,	 "Sbrk",   1, TRUE,  SysSbrk },
+    { SC_UpcallSetup, "UpcallSetup", 2, TRUE, SysUpcallSetup },
+};
+
+#define NumSyscalls	(int)(sizeof(syscallTable) / sizeof(SyscallEntry))
+
+//----------------------------------------------------------------------
+// RunHandler
+// 	Run the handler of a system call, whether it was trapped to or
+//	taken from a submission ring.  The call is counted before the
+//	handler runs, since Exit and Halt never return; the time the
+//	handler takes is recorded in the latency histogram.
+//
+//	"type" is the system call code
+//	"arg" are its arguments
+//----------------------------------------------------------------------
+
+static int
+RunHandler(int type, int *arg)
+{
+    SyscallEntry *entry = &syscallTable[type];
+    int result, start = stats->totalTicks;
+
+    ASSERT(type >= 0 && type < NumSyscalls && type < MaxSyscalls);
+    ASSERT(entry->type == type);
+    DEBUG('c', "%s: %s(%d, %d, %d)\n", currentThread->getName(), entry->name,
+        arg[0], arg[1], arg[2]);
+    stats->syscallName[type] = entry->name;
+    stats->numSyscalls[type]++;
+    result = (*entry->handler)(arg[0], arg[1], arg[2], arg[3]);
+    stats->SyscallDone(type, stats->totalTicks - start);
+    if (entry->hasResult) {
+        DEBUG('c', "%s returns %d\n", entry->name, result);
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------
+// Syscall
+// 	Decode a system call, run its handler, and return to the user
+//	program after the syscall instruction.
+//
+//	"type" is the system call code, from r2
+//----------------------------------------------------------------------
+
+static void
+Syscall(int type)
+{
+    SyscallEntry *entry;
+    int arg[4], result;
+
+    if (type < 0 || type >= NumSyscalls || type >= MaxSyscalls) {
+        printf("Unknown system call %d\n", type);
+        ASSERT(FALSE);
+    }
+    entry = &syscallTable[type];
+    for (int i = 0; i < 4; i++)
+        arg[i] = (i < entry->numArgs) ? machine->ReadRegister(4 + i) : 0;
+    currentThread->inSyscall = (currentThread->process->upcall != -1);
+    result = RunHandler(type, arg);
+    currentThread->inSyscall = FALSE;
+    if (entry->hasResult) {
+        machine->WriteRegister(2, result);
+    }
+    machine->PCAdvance();
+}
+
+//----------------------------------------------------------------------
+// ExceptionHandler
+// 	Entry point into the Nachos kernel.  Called when a user program
+//	is executing, and either does a syscall, or generates an addressing
+//	or arithmetic exception.
+//
+// 	For system calls, the following is the calling convention:
+//
+// 	system call code -- r2
+//		arg1 -- r4
+//		arg2 -- r5
+//		arg3 -- r6
+//		arg4 -- r7
+//
+//	The result of the system call, if any, must be put back into r2. 
+//
+// And don't forget to increment the pc before returning. (Or else you'll
+// loop making the same system call forever!
+//
+//	"which" is the kind of exception.  The list of possible exceptions 
+//	are in machine.h.
+//----------------------------------------------------------------------
+
+void
+ExceptionHandler(ExceptionType which)
+{
+    int type = machine->ReadRegister(2);
+
+    if (which == SyscallException) {
+        Syscall(type);
     }
 
     else if (which == PageFaultException) {
-        int method = 0;
-        if (machine->tlb == NULL) {
-            OpenFile *openfile = fileSystem->Open("virtual_memory");
-            if (openfile == NULL) ASSERT(false);
-            int virtAddr = machine->registers[BadVAddrReg];
-            unsigned int vpn = (unsigned) virtAddr / PageSize;
-            unsigned int offset = (unsigned) virtAddr % PageSize;
-            int pos = machine->bitmap->find();
-
-            if (pos == -1) {
-                pos = 0;
-                for (int j = 0; j < machine->pageTableSize; j++) {
-                    if (machine->pageTable[j].physicalPage == 0) {
-                        if (machine->pageTable[j].dirty == TRUE) {
-                            openfile->WriteAt(&(machine->mainMemory[pos * PageSize]),
-                                PageSize, machine->pageTable[j].virtualPage * PageSize);
-                            machine->pageTable[j].valid = FALSE;
-                            break;
-                        }
-                    }
-                }
+        int virtAddr = machine->ReadRegister(BadVAddrReg);
+        unsigned int vpn = (unsigned) virtAddr / PageSize;
+        TranslationEntry *entry;
+
+        if (!currentThread->space->ValidFault(virtAddr)) {
+            printf("Bad address 0x%x in process %d\n", virtAddr,
+                currentThread->process->pid);
+            EndThread(TRUE, -1);
+        }
+
+        // bring the page into memory, unless it is only missing 
+        // from the TLB
+        frameTable->lock->Acquire();
+        entry = currentThread->space->PageEntry(vpn);
+        if (entry == NULL || !entry->valid) {
+            frameTable->Admit(currentThread->space);	// may suspend us
+
+            // while we slept, another thread of the process may have
+            // taken the same fault, and paged it in already
+            entry = currentThread->space->PageEntry(vpn);
+            if (entry == NULL || !entry->valid) {
+                currentThread->space->PageIn(vpn);
+                entry = currentThread->space->PageEntry(vpn);
             }
-            //printf("PageFault vpn %d pos %d\n", vpn, pos);
-            openfile->ReadAt(&(machine->mainMemory[pos * PageSize]), PageSize, vpn * PageSize);
-            machine->pageTable[pos].valid = TRUE;
-            machine->pageTable[pos].virtualPage = vpn;
-            //machine->pageTable[vpn].physicalPage = pos;
-            machine->pageTable[pos].use = FALSE;
-            machine->pageTable[pos].dirty = FALSE;
-            machine->pageTable[pos].readOnly = FALSE;
-            delete openfile;
         }
-        else {
-            TranslationEntry *entry, *tlb;
-            int virtAddr = machine->registers[BadVAddrReg];
-            unsigned int vpn = (unsigned) virtAddr / PageSize;
-            unsigned int offset = (unsigned) virtAddr % PageSize;
-            entry = &machine->pageTable[vpn];
-            tlb = machine->tlb;
-            bool flag = false;
 
+        if (machine->tlb != NULL) {
+            TranslationEntry *tlb = machine->tlb;
+            int victim = -1;
+
+            // LRU: take a free slot, or else the one unused the longest
             for (int i = 0; i < TLBSize; i++) {
                 if (tlb[i].valid) {
                     tlb[i].cnt++;
                 }
-            }
-
-            for (int i = 0; i < TLBSize; i++) {
-                if (!tlb[i].valid) {
-                    tlb[i].valid = true;
-                    tlb[i].virtualPage = entry->virtualPage;
-                    tlb[i].physicalPage = entry->physicalPage;
-                    tlb[i].readOnly = entry->readOnly;
-                    tlb[i].use = false;
-                    tlb[i].dirty = false;
-                    tlb[i].cnt = 0;
-
-                    flag = true;
-                    break;
+                else if (victim == -1) {
+                    victim = i;
                 }
             }
-            if (!flag) {
-                int maxcnt = 0;
-                int maxidx = -1;
-                for (int i = 0; i < TLBSize; i++) {
-                    if (tlb[i].cnt > maxcnt) {
-                        maxcnt = tlb[i].cnt;
-                        maxidx = i;
+            if (victim == -1) {
+                victim = 0;
+                for (int i = 1; i < TLBSize; i++) {
+                    if (tlb[i].cnt > tlb[victim].cnt) {
+                        victim = i;
                     }
                 }
-                tlb[maxidx].virtualPage = entry->virtualPage;
-                tlb[maxidx].physicalPage = entry->physicalPage;
-                tlb[maxidx].readOnly = entry->readOnly;
-                tlb[maxidx].use = false;
-                tlb[maxidx].dirty = false;
-                tlb[maxidx].cnt = 0;
             }
+            if (tlb[victim].valid) {
+                currentThread->space->SyncTLB();
+            }
+            tlb[victim].valid = true;
+            tlb[victim].virtualPage = entry->virtualPage;
+            tlb[victim].physicalPage = entry->physicalPage;
+            tlb[victim].readOnly = entry->readOnly;
+            tlb[victim].shared = entry->shared;
+            tlb[victim].use = false;
+            tlb[victim].dirty = false;
+            tlb[victim].cnt = 0;
         }
+        frameTable->lock->Release();
     }
     else {
         printf("Unexpected user mode exception %d %d\n", which, type);
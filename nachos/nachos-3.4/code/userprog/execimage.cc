@@ -0,0 +1,225 @@
+// execimage.cc
+//	Routines to cache the images of executables.
+//
+//	Images are read in without holding the cache lock, since reading
+//	blocks on the disk; two threads loading the same executable at
+//	once both read it, and the second one throws its copy away.  When
+//	the cache is full, the image least recently asked for is dropped.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "execimage.h"
+#include "system.h"
+#include "synch.h"
+#ifdef HOST_SPARC
+#include <strings.h>
+#endif
+
+//----------------------------------------------------------------------
+// SwapHeader
+// 	Do little endian to big endian conversion on the bytes in the 
+//	object file header, in case the file was generated on a little
+//	endian machine, and we're now running on a big endian machine.
+//----------------------------------------------------------------------
+
+static void 
+SwapHeader (NoffHeader *noffH)
+{
+	noffH->noffMagic = WordToHost(noffH->noffMagic);
+	noffH->code.size = WordToHost(noffH->code.size);
+	noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
+	noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
+	noffH->initData.size = WordToHost(noffH->initData.size);
+	noffH->initData.virtualAddr = WordToHost(noffH->initData.virtualAddr);
+	noffH->initData.inFileAddr = WordToHost(noffH->initData.inFileAddr);
+	noffH->uninitData.size = WordToHost(noffH->uninitData.size);
+	noffH->uninitData.virtualAddr = WordToHost(noffH->uninitData.virtualAddr);
+	noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
+}
+
+//----------------------------------------------------------------------
+// ExecImage::ExecImage
+// 	Load the image of an executable: parse its NOFF header, and read
+//	its code and initialized data into memory, at the offsets they
+//	have in the address space.  The gaps between them are zeroes.
+//
+//	Assumes that the object code file is in NOFF format.
+//
+//	"executable" is the file containing the object code
+//----------------------------------------------------------------------
+
+ExecImage::ExecImage(OpenFile *executable)
+{
+    int imageSize;
+
+    key = executable->HeaderSector();
+    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
+    if ((noffH.noffMagic != NOFFMAGIC) && 
+		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
+    	SwapHeader(&noffH);
+    ASSERT(noffH.noffMagic == NOFFMAGIC);
+
+    imageSize = 0;
+    if (noffH.code.size > 0)
+	imageSize = noffH.code.virtualAddr + noffH.code.size;
+    if (noffH.initData.size > 0 &&
+		noffH.initData.virtualAddr + noffH.initData.size > imageSize)
+	imageSize = noffH.initData.virtualAddr + noffH.initData.size;
+    numPages = divRoundUp(imageSize, PageSize);
+    pages = new char[numPages * PageSize + 1];	// never empty
+    bzero(pages, numPages * PageSize);
+    if (noffH.code.size > 0) {
+	DEBUG('a', "Initializing code segment, at 0x%x, size %d\n", 
+			noffH.code.virtualAddr, noffH.code.size);
+	executable->ReadAt(&pages[noffH.code.virtualAddr],
+			noffH.code.size, noffH.code.inFileAddr);
+    }
+    if (noffH.initData.size > 0) {
+	DEBUG('a', "Initializing data segment, at 0x%x, size %d\n", 
+			noffH.initData.virtualAddr, noffH.initData.size);
+	executable->ReadAt(&pages[noffH.initData.virtualAddr],
+			noffH.initData.size, noffH.initData.inFileAddr);
+    }
+    refCount = 0;
+    cached = FALSE;
+    lastUse = stats->totalTicks;
+}
+
+ExecImage::~ExecImage()
+{
+    delete [] pages;
+}
+
+//----------------------------------------------------------------------
+// ExecImageCache::ExecImageCache
+// 	Initialize an empty cache.
+//----------------------------------------------------------------------
+
+ExecImageCache::ExecImageCache()
+{
+    lock = new Lock("exec image cache");
+    for (int i = 0; i < MaxExecImages; i++)
+	images[i] = NULL;
+    hits = misses = 0;
+}
+
+//----------------------------------------------------------------------
+// ExecImageCache::~ExecImageCache
+// 	De-allocate the cache, and the images no address space is using.
+//----------------------------------------------------------------------
+
+ExecImageCache::~ExecImageCache()
+{
+    DEBUG('a', "Exec image cache: %d hits, %d misses\n", hits, misses);
+    for (int i = 0; i < MaxExecImages; i++)
+	if (images[i] != NULL && images[i]->refCount == 0)
+	    delete images[i];
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// ExecImageCache::Get
+// 	Return the image of an executable, for a new address space to be
+//	loaded from.  If it is not cached, read it in and cache it, in
+//	place of the image least recently asked for if the cache is full.
+//	The caller must Release the image when the address space goes.
+//
+//	"executable" is the file the program is loaded from
+//----------------------------------------------------------------------
+
+ExecImage *
+ExecImageCache::Get(OpenFile *executable)
+{
+    int key = executable->HeaderSector();
+    ExecImage *image, *loaded;
+    int i, victim;
+
+    lock->Acquire();
+    for (i = 0; i < MaxExecImages; i++)
+	if (images[i] != NULL && images[i]->key == key)
+	    break;
+    if (i < MaxExecImages) {
+	hits++;
+	image = images[i];
+	image->refCount++;
+	image->lastUse = stats->totalTicks;
+	lock->Release();
+	DEBUG('a', "Exec image of file %d is cached\n", key);
+	return image;
+    }
+    misses++;
+    lock->Release();
+
+    loaded = new ExecImage(executable);		// may block on the disk
+
+    lock->Acquire();
+    victim = -1;
+    for (i = 0; i < MaxExecImages; i++) {
+	if (images[i] != NULL && images[i]->key == key)
+	    break;				// someone beat us to it
+	if (victim == -1 || (images[victim] != NULL && (images[i] == NULL
+		|| images[i]->lastUse < images[victim]->lastUse)))
+	    victim = i;
+    }
+    if (i < MaxExecImages) {
+	image = images[i];
+	delete loaded;
+    } else {
+	image = loaded;
+	if (images[victim] != NULL) {
+	    DEBUG('a', "Dropping exec image of file %d\n", images[victim]->key);
+	    images[victim]->cached = FALSE;
+	    if (images[victim]->refCount == 0)
+		delete images[victim];
+	}
+	images[victim] = image;
+	image->cached = TRUE;
+    }
+    image->refCount++;
+    image->lastUse = stats->totalTicks;
+    lock->Release();
+    return image;
+}
+
+//----------------------------------------------------------------------
+// ExecImageCache::Release
+// 	An address space loaded from an image is going away.  An image
+//	dropped from the cache is deleted by its last user.
+//----------------------------------------------------------------------
+
+void
+ExecImageCache::Release(ExecImage *image)
+{
+    lock->Acquire();
+    ASSERT(image->refCount > 0);
+    if (--image->refCount == 0 && !image->cached)
+	delete image;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ExecImageCache::Invalidate
+// 	A file has been written (or created anew): if it is a cached
+//	executable, drop its image, so the next Exec reads the new one.
+//	Programs already running keep the image they were loaded from.
+//
+//	"key" is the header sector of the file
+//----------------------------------------------------------------------
+
+void
+ExecImageCache::Invalidate(int key)
+{
+    lock->Acquire();
+    for (int i = 0; i < MaxExecImages; i++)
+	if (images[i] != NULL && images[i]->key == key) {
+	    DEBUG('a', "Exec image of file %d is stale\n", key);
+	    images[i]->cached = FALSE;
+	    if (images[i]->refCount == 0)
+		delete images[i];
+	    images[i] = NULL;
+	}
+    lock->Release();
+}
@@ -0,0 +1,78 @@
+// execimage.h
+//	Data structures to cache the executables user programs are loaded
+//	from.
+//
+//	An ExecImage holds the parsed NOFF header of an executable and its
+//	code and initialized data, laid out page by page as they appear in
+//	the address space.  Address spaces page those pages in straight
+//	from the image, so running the same program again, as a shell or a
+//	test harness does, reads nothing from the disk.
+//
+//	Images are kept in a small cache, looked up by the sector of the
+//	file header, and thrown out when the file is written.  An image
+//	still used by an address space lives on until its last user is
+//	gone, even once it has been thrown out of the cache.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EXECIMAGE_H
+#define EXECIMAGE_H
+
+#include "copyright.h"
+#include "openfile.h"
+#include "noff.h"
+#include "machine.h"
+
+#define MaxExecImages	8	// executables cached at one time
+
+class Lock;
+
+// The following class defines the loaded image of one executable.
+
+class ExecImage {
+  public:
+    ExecImage(OpenFile *executable);	// Parse the header and read in
+					// the code and initialized data
+    ~ExecImage();
+
+    char *Page(int vpn) { return &pages[vpn * PageSize]; }
+					// Initial contents of "vpn", which
+					// must be below numPages
+
+    int key;				// header sector of the executable
+    NoffHeader noffH;			// header, in host byte order
+    int numPages;			// pages holding code or data; the
+					// rest start out zero-filled
+    int refCount;			// address spaces using the image
+    bool cached;			// still in the cache?
+    int lastUse;			// stats->totalTicks of the last Exec
+
+  private:
+    char *pages;			// the code and data, by address
+};
+
+// The following class defines the cache of executable images.
+
+class ExecImageCache {
+  public:
+    ExecImageCache();			// Initialize an empty cache
+    ~ExecImageCache();			// De-allocate the cache and the
+					// images nobody uses
+
+    ExecImage *Get(OpenFile *executable);
+					// Return the image of "executable",
+					// loading it if it is not cached
+    void Release(ExecImage *image);	// An address space is done with
+					// "image"
+    void Invalidate(int key);		// The file whose header is in
+					// sector "key" has been written
+
+  private:
+    Lock *lock;				// protects the cache, not the I/O
+    ExecImage *images[MaxExecImages];	// cached images, NULL if unused
+    int hits, misses;
+};
+
+#endif // EXECIMAGE_H
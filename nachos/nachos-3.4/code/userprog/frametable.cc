@@ -0,0 +1,702 @@
+// frametable.cc
+//	Routines to allocate physical page frames to address spaces, and
+//	to choose a victim frame when physical memory is full.
+//
+//	Replacement is the clock algorithm: the hand sweeps the frames,
+//	clearing the use bit of every page it passes over, and evicts
+//	the first page whose use bit is already clear.
+//
+//	Working sets are estimated from the same use bits: on every timer
+//	interrupt, SampleReferences shifts each frame's use bit into its
+//	"age", and the working set of an address space is the number of
+//	its frames referenced during the last eight samples.  On each page
+//	fault, Admit adjusts the estimate by the classic page fault
+//	frequency rule (a short gap since the previous fault grows it, a
+//	long gap trims the pages not used since), and suspends the faulting
+//	process if the working sets of all the running processes add up to
+//	more than physical memory.  Suspended processes are resumed, oldest
+//	first, when processes exit or working sets shrink.
+//
+//	The timer only runs with -rs, so references are only sampled then.
+//	Without it, the working sets come from the page fault frequency
+//	rule alone: they grow by a page on each short gap between faults,
+//	and are trimmed to the pages used since the last fault on a long
+//	one.
+//
+//	Free frames are kept in two pools (contents unknown, and zeroed).
+//	The pager thread sleeps until the pools drop below PagerLowWater,
+//	then evicts pages until PagerHighWater frames are free: clean
+//	pages are freed right away, dirty ones are unmapped and written
+//	back in runs of consecutive pages of the same swap file, one
+//	WriteAt per run, without holding "lock".  It also zeroes free
+//	frames ahead of time, for pages that have no copy on disk.
+//
+//	Except for SampleReferences, the caller must hold "lock".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "frametable.h"
+#include "addrspace.h"
+#include "sharedtext.h"
+#include "mappedfile.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// PagerThread
+// 	Entry point of the pager thread; Thread::Fork only takes an
+//	int argument, so the frame table is passed through it.
+//----------------------------------------------------------------------
+
+static void
+PagerThread(int arg)
+{
+    FrameTable *table = (FrameTable *) arg;
+
+    table->Pager();
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FrameTable
+// 	Initialize the frame table.  Every frame starts out free, and
+//	zeroed (the machine clears its memory when it starts up).  Then
+//	start the pager thread; it sleeps until the pools run low.
+//----------------------------------------------------------------------
+
+FrameTable::FrameTable()
+{
+    Thread *pager;
+
+    numFree = 0;
+    numZero = 0;
+    for (int i = 0; i < NumPhysPages; i++) {
+	frames[i].space = NULL;
+	frames[i].text = NULL;
+	frames[i].mapped = NULL;
+	frames[i].vpn = -1;
+	frames[i].age = 0;
+	frames[i].busy = FALSE;
+	zeroFrames[numZero++] = NumPhysPages - 1 - i;
+    }
+    hand = 0;
+    lock = new Lock("frame table");
+    pagerWork = new Condition("pager work");
+    cleaned = new Condition("pages cleaned");
+    totalWorkingSet = 0;
+    activeSpaces = 0;
+
+    pager = Thread::createThread("pager");
+    pager->Fork(PagerThread, (int) this);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::~FrameTable
+// 	De-allocate the frame table.
+//----------------------------------------------------------------------
+
+FrameTable::~FrameTable()
+{
+    delete lock;
+    delete pagerWork;
+    delete cleaned;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateFrame
+// 	Find a physical frame to hold a virtual page.  Normally it comes
+//	from one of the free pools: a zeroed frame if the caller wants
+//	one, so a page that has never been written costs no I/O at all.
+//	If the pools are empty (the pager has not kept up), evict the
+//	page chosen by FindVictim ourselves, writing it back if dirty.
+//
+//	Wakes up the pager when the pools drop below PagerLowWater.
+//
+//	"space" is the address space the page belongs to
+//	"vpn" is the virtual page that will be loaded into the frame
+//	"zero" is TRUE if the frame must be zero-filled
+//----------------------------------------------------------------------
+
+int
+FrameTable::AllocateFrame(AddrSpace *space, int vpn, bool zero)
+{
+    bool isZero = FALSE;
+    int frame;
+
+    if (numFree + numZero < PagerLowWater)
+	pagerWork->Signal(lock);
+
+    if (zero && numZero > 0) {
+	frame = zeroFrames[--numZero];
+	isZero = TRUE;
+    } else if (numFree > 0) {
+	frame = freeFrames[--numFree];
+    } else if (numZero > 0) {
+	frame = zeroFrames[--numZero];
+	isZero = TRUE;
+    } else {
+	if (currentThread->space != NULL)
+	    currentThread->space->SyncTLB();	// pick up the use bits
+	frame = FindVictim();
+	ASSERT(frame != -1);
+	Evict(frame);
+    }
+    if (zero && !isZero)
+	bzero(&machine->mainMemory[frame * PageSize], PageSize);
+
+    frames[frame].space = space;
+    frames[frame].text = NULL;
+    frames[frame].mapped = NULL;
+    frames[frame].vpn = vpn;
+    frames[frame].age = 0;
+    frames[frame].busy = FALSE;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateTextFrame
+// 	Find a physical frame to hold a page of shared code.  The frame
+//	belongs to the shared text rather than to an address space.
+//
+//	"text" is the shared text the page belongs to
+//	"vpn" is the virtual page that will be loaded into the frame
+//----------------------------------------------------------------------
+
+int
+FrameTable::AllocateTextFrame(SharedText *text, int vpn)
+{
+    int frame = AllocateFrame(NULL, vpn, FALSE);
+
+    frames[frame].text = text;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateMappedFrame
+// 	Find a physical frame to hold a page of a mapped file.  The frame
+//	belongs to the mapped file rather than to an address space.
+//
+//	"mapped" is the mapped file the page belongs to
+//	"page" is the page number within the file
+//----------------------------------------------------------------------
+
+int
+FrameTable::AllocateMappedFrame(MappedFile *mapped, int page)
+{
+    int frame = AllocateFrame(NULL, page, FALSE);
+
+    frames[frame].mapped = mapped;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FreeFrame
+// 	Put a frame back in the free pool.  The caller has already
+//	invalidated the page table entry pointing at it.
+//----------------------------------------------------------------------
+
+void
+FrameTable::FreeFrame(int frame)
+{
+    ASSERT(frames[frame].space != NULL || frames[frame].text != NULL ||
+	frames[frame].mapped != NULL);
+    frames[frame].space = NULL;
+    frames[frame].text = NULL;
+    frames[frame].mapped = NULL;
+    frames[frame].vpn = -1;
+    frames[frame].busy = FALSE;
+    freeFrames[numFree++] = frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FreeAll
+// 	Free every frame held by an address space, when it is destroyed.
+//	Nothing is written back -- the pages are not needed any more.
+//----------------------------------------------------------------------
+
+void
+FrameTable::FreeAll(AddrSpace *space)
+{
+    for (int i = 0; i < NumPhysPages; i++)
+	if (frames[i].space == space)
+	    FreeFrame(i);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Reclaim
+// 	A page fault on a page the pager has unmapped, but not finished
+//	writing out, can take the frame back instead of reading the page
+//	from the swap file.  The pager notices when the write completes,
+//	and leaves the frame alone.
+//
+//	"space", "vpn" identify the faulting page
+//	"frame" is the frame the page table entry last pointed to
+//----------------------------------------------------------------------
+
+bool
+FrameTable::Reclaim(AddrSpace *space, int vpn, int frame)
+{
+    if (frame < 0 || frame >= NumPhysPages || !frames[frame].busy ||
+	    frames[frame].space != space || frames[frame].vpn != vpn)
+	return FALSE;
+    DEBUG('a', "Reclaiming vpn %d in frame %d\n", vpn, frame);
+    frames[frame].age = 0;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FindVictim
+// 	Choose a frame to evict, using the clock algorithm.  Free frames
+//	and frames being written back are skipped.  Returns -1 if two
+//	sweeps find nothing to evict.
+//----------------------------------------------------------------------
+
+int
+FrameTable::FindVictim()
+{
+    TranslationEntry *entry;
+    int victim;
+    bool used;
+
+    for (int i = 0; i < 2 * NumPhysPages; i++) {
+	victim = hand;
+	hand = (hand + 1) % NumPhysPages;
+	if (frames[victim].busy)
+	    continue;
+	if (frames[victim].text != NULL)
+	    used = frames[victim].text->Referenced(frames[victim].vpn);
+	else if (frames[victim].mapped != NULL)
+	    used = frames[victim].mapped->Referenced(frames[victim].vpn);
+	else if (frames[victim].space != NULL) {
+	    entry = frames[victim].space->PageEntry(frames[victim].vpn);
+	    ASSERT(entry != NULL && entry->valid);
+	    used = entry->use;
+	    entry->use = FALSE;
+	} else
+	    continue;			// free
+	if (!used)
+	    return victim;
+	frames[victim].age |= 0x80;	// don't lose the reference
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Evict
+// 	Throw out the page held in a frame, so that the frame can be
+//	reused.  A page of shared code is unmapped from all of its users;
+//	a page of a mapped file, too, and written back to the file if
+//	dirty; a private page is written back to its swap file if dirty.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Evict(int frame)
+{
+    DEBUG('a', "Evicting vpn %d from frame %d\n", frames[frame].vpn, frame);
+    if (frames[frame].text != NULL)
+	frames[frame].text->Evict(frames[frame].vpn);
+    else if (frames[frame].mapped != NULL)
+	frames[frame].mapped->Evict(frames[frame].vpn);
+    else
+	frames[frame].space->PageOut(frames[frame].vpn);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Print
+// 	Print the contents of the frame table, for debugging.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Print()
+{
+    printf("Frame table contents:\n");
+    for (int i = 0; i < NumPhysPages; i++)
+	if (frames[i].space != NULL)
+	    printf("frame %d: space 0x%x, vpn %d\n", i,
+		(int) frames[i].space, frames[i].vpn);
+	else if (frames[i].text != NULL)
+	    printf("frame %d: shared text 0x%x, vpn %d\n", i,
+		(int) frames[i].text, frames[i].vpn);
+	else if (frames[i].mapped != NULL)
+	    printf("frame %d: mapped file 0x%x, page %d\n", i,
+		(int) frames[i].mapped, frames[i].vpn);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AddSpace
+// 	Start tracking the working set of a new address space.  It starts
+//	out empty; it grows as the process faults its pages in.
+//----------------------------------------------------------------------
+
+void
+FrameTable::AddSpace(AddrSpace *space)
+{
+    space->workingSet = 0;
+    space->lastFault = stats->totalTicks;
+    space->suspended = FALSE;
+    space->justResumed = FALSE;
+    activeSpaces++;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::RemoveSpace
+// 	Stop tracking an address space, when it is destroyed, and give
+//	its frames back.  The memory it frees may let a suspended process
+//	run again.
+//----------------------------------------------------------------------
+
+void
+FrameTable::RemoveSpace(AddrSpace *space)
+{
+    bool writing;
+
+    ASSERT(!space->suspended);
+    do {				// wait for the pager to finish
+	writing = FALSE;		// with our swap file
+	for (int i = 0; i < NumPhysPages; i++)
+	    if (frames[i].space == space && frames[i].busy)
+		writing = TRUE;
+	if (writing)
+	    cleaned->Wait(lock);
+    } while (writing);
+    FreeAll(space);
+    totalWorkingSet -= space->workingSet;
+    activeSpaces--;
+    ResumeWaiting();
+}
+
+//----------------------------------------------------------------------
+// FrameTable::SampleReferences
+// 	Called from the timer interrupt handler, so only with -rs.  Shift
+//	the use bit of every resident page into its age, clear the use
+//	bit, and set the working set of each address space to the number
+//	of its pages with a non-zero age.  Address spaces with no resident
+//	pages keep their old estimate.
+//
+//	Runs with interrupts off, so it cannot take "lock"; page faults in
+//	progress are left alone (their entry is not valid yet).
+//----------------------------------------------------------------------
+
+void
+FrameTable::SampleReferences()
+{
+    TranslationEntry *entry;
+    AddrSpace *space;
+    int i;
+
+    if (currentThread->space != NULL)
+	currentThread->space->SyncTLB();	// pick up the use bits
+
+    for (i = 0; i < NumPhysPages; i++)
+	if (frames[i].space != NULL)
+	    frames[i].space->sampled = 0;
+    for (i = 0; i < NumPhysPages; i++) {
+	space = frames[i].space;
+	if (space == NULL)
+	    continue;
+	entry = space->PageEntry(frames[i].vpn);
+	if (entry == NULL || !entry->valid)
+	    continue;
+	frames[i].age = (frames[i].age >> 1) | (entry->use ? 0x80 : 0);
+	entry->use = FALSE;
+	if (frames[i].age != 0)
+	    space->sampled++;
+    }
+    for (i = 0; i < NumPhysPages; i++) {
+	space = frames[i].space;
+	if (space != NULL && space->sampled >= 0) {
+	    SetWorkingSet(space, space->sampled);
+	    space->sampled = -1;		// only once per space
+	}
+    }
+    ResumeWaiting();
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Admit
+// 	The page fault frequency controller, called on each page fault
+//	before the page is brought in.
+//
+//	If the process faulted soon after its previous fault, it needs
+//	more frames than it has: its working set is at least what it holds
+//	plus the page it is asking for.  Otherwise, the pages it has not
+//	touched since the previous fault are no longer in its working set,
+//	and are freed right away.
+//
+//	Then, if the working sets of the running processes no longer fit
+//	in memory, the faulting process is suspended.  The last running
+//	process is never suspended, and a process that was just resumed
+//	is let through once, so it can make progress.
+//
+//	"space" is the address space of the faulting thread
+//----------------------------------------------------------------------
+
+void
+FrameTable::Admit(AddrSpace *space)
+{
+    int interval;
+
+    if (space->suspended) {		// another thread of the same
+	Suspend(space);			// process was suspended
+	return;
+    }
+    interval = stats->totalTicks - space->lastFault;
+    space->lastFault = stats->totalTicks;
+    if (interval <= PFFThreshold) {
+	if (space->workingSet <= Resident(space))
+	    SetWorkingSet(space, Resident(space) + 1);
+    } else {
+	Trim(space);
+	SetWorkingSet(space, Resident(space) + 1);
+    }
+
+    if (space->justResumed) {
+	space->justResumed = FALSE;
+	return;
+    }
+    if (totalWorkingSet > NumPhysPages && activeSpaces > 1) {
+	DEBUG('a', "Working sets total %d frames, suspending a process\n",
+		totalWorkingSet);
+	Suspend(space);
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Resident
+// 	Return the number of frames held by an address space.
+//----------------------------------------------------------------------
+
+int
+FrameTable::Resident(AddrSpace *space)
+{
+    int count = 0;
+
+    for (int i = 0; i < NumPhysPages; i++)
+	if (frames[i].space == space && !frames[i].busy)
+	    count++;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Trim
+// 	Page out the frames of an address space whose use bit is clear,
+//	and clear the use bit of the others.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Trim(AddrSpace *space)
+{
+    TranslationEntry *entry;
+
+    space->SyncTLB();
+    for (int i = 0; i < NumPhysPages; i++) {
+	if (frames[i].space != space || frames[i].busy)
+	    continue;
+	entry = space->PageEntry(frames[i].vpn);
+	if (entry->use) {
+	    entry->use = FALSE;
+	    continue;
+	}
+	space->PageOut(frames[i].vpn);
+	FreeFrame(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::SetWorkingSet
+// 	Change the working set estimate of an address space, keeping the
+//	total of the running processes up to date.
+//----------------------------------------------------------------------
+
+void
+FrameTable::SetWorkingSet(AddrSpace *space, int size)
+{
+    if (size > NumPhysPages)
+	size = NumPhysPages;
+    if (!space->suspended)
+	totalWorkingSet += size - space->workingSet;
+    space->workingSet = size;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Suspend
+// 	Swap out the faulting process: write back its dirty pages, free
+//	all of its frames, and put the current thread to sleep until
+//	ResumeWaiting decides there is room for it.  Its working set
+//	estimate is kept, to decide when to let it back in.
+//
+//	"lock" is released while we sleep, and held again on return.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Suspend(AddrSpace *space)
+{
+    IntStatus oldLevel;
+
+    if (!space->suspended) {
+	space->suspended = TRUE;
+	totalWorkingSet -= space->workingSet;
+	activeSpaces--;
+	stats->numSuspends++;
+	for (int i = 0; i < NumPhysPages; i++)
+	    if (frames[i].space == space && !frames[i].busy) {
+		space->PageOut(frames[i].vpn);
+		FreeFrame(i);
+	    }
+	ResumeWaiting();		// maybe someone else fits now
+    }
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    if (space->suspended) {		// still not let back in
+	suspended.Append(currentThread);
+	lock->Release();
+	currentThread->Sleep();
+	lock->Acquire();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::ResumeWaiting
+// 	Let suspended processes run again, in the order they were
+//	suspended, as long as their working sets fit in the memory left
+//	by the running ones.  If nobody is running, the first one is let
+//	in whatever its size.  Every thread of a resumed process is woken.
+//----------------------------------------------------------------------
+
+void
+FrameTable::ResumeWaiting()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread, *next;
+    AddrSpace *space;
+
+    while (!suspended.IsEmpty()) {
+	space = suspended.Head()->space;
+	if (activeSpaces > 0 &&
+		totalWorkingSet + space->workingSet > NumPhysPages)
+	    break;
+
+	DEBUG('a', "Resuming a process, working set %d\n", space->workingSet);
+	space->suspended = FALSE;
+	space->justResumed = TRUE;
+	space->lastFault = stats->totalTicks;
+	totalWorkingSet += space->workingSet;
+	activeSpaces++;
+
+	for (thread = suspended.Head(); thread != NULL; thread = next) {
+	    next = suspended.Next(thread);
+	    if (thread->space == space) {
+		suspended.Unlink(thread);
+		scheduler->ReadyToRun(thread);
+	    }
+	}
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Pager
+// 	The pager thread.  Sleep until a page fault finds the free pools
+//	below PagerLowWater, then refill them.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Pager()
+{
+    lock->Acquire();
+    for (;;) {
+	pagerWork->Wait(lock);
+	Clean();
+	ZeroFree();
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Clean
+// 	Evict pages until PagerHighWater frames are free.  Clean pages
+//	are freed at once.  Dirty pages are unmapped and marked busy, then
+//	sorted by address space and virtual page, and each run of
+//	consecutive pages is written to the swap file with a single write.
+//	"lock" is released during the writes, so page faults can proceed;
+//	a fault on a page still being written takes it back (Reclaim).
+//----------------------------------------------------------------------
+
+void
+FrameTable::Clean()
+{
+    int batch[PagerHighWater];
+    int n = 0, frame, i, j;
+    AddrSpace *space;
+    TranslationEntry *entry;
+
+    while (numFree + numZero + n < PagerHighWater) {
+	frame = FindVictim();
+	if (frame == -1)
+	    break;
+	if (frames[frame].space == NULL) {	// shared code, mapped file
+	    Evict(frame);
+	    FreeFrame(frame);
+	} else if (frames[frame].space->Unmap(frames[frame].vpn)) {
+	    frames[frame].busy = TRUE;
+	    batch[n++] = frame;
+	} else
+	    FreeFrame(frame);
+    }
+    if (n == 0)
+	return;
+
+    for (i = 1; i < n; i++) {		// insertion sort by (space, vpn)
+	frame = batch[i];
+	for (j = i; j > 0; j--) {
+	    FrameEntry *prev = &frames[batch[j - 1]];
+	    if ((int) prev->space < (int) frames[frame].space ||
+		    (prev->space == frames[frame].space &&
+		    prev->vpn < frames[frame].vpn))
+		break;
+	    batch[j] = batch[j - 1];
+	}
+	batch[j] = frame;
+    }
+
+    lock->Release();
+    for (i = 0; i < n; i = j) {
+	space = frames[batch[i]].space;
+	for (j = i + 1; j < n && frames[batch[j]].space == space &&
+		frames[batch[j]].vpn == frames[batch[j - 1]].vpn + 1; j++)
+	    ;
+	DEBUG('a', "Pager writing vpn %d-%d\n", frames[batch[i]].vpn,
+		frames[batch[j - 1]].vpn);
+	space->WriteSwap(frames[batch[i]].vpn, &batch[i], j - i);
+    }
+    lock->Acquire();
+
+    for (i = 0; i < n; i++) {
+	frame = batch[i];
+	entry = frames[frame].space->PageEntry(frames[frame].vpn);
+	if (entry->valid && entry->physicalPage == frame)
+	    frames[frame].busy = FALSE;		// reclaimed meanwhile
+	else
+	    FreeFrame(frame);
+    }
+    cleaned->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::ZeroFree
+// 	Zero free frames until PagerZeroFrames of them are ready for
+//	pages that have never been written to the swap file.
+//----------------------------------------------------------------------
+
+void
+FrameTable::ZeroFree()
+{
+    int frame;
+
+    while (numZero < PagerZeroFrames && numFree > 0) {
+	frame = freeFrames[--numFree];
+	bzero(&machine->mainMemory[frame * PageSize], PageSize);
+	zeroFrames[numZero++] = frame;
+    }
+}
@@ -0,0 +1,138 @@
+// frametable.h
+//	Data structures to keep track of the physical page frames of the
+//	simulated machine (the "core map").
+//
+//	Page tables map virtual pages to frames; the frame table maps
+//	frames back to the address space and virtual page they hold, so
+//	that when memory is full we can pick a victim frame and tell its
+//	owner to page it out.
+//
+//	The frame table also estimates the working set of every address
+//	space, and runs a page fault frequency (PFF) controller: when the
+//	working sets of the running processes no longer fit in physical
+//	memory, a faulting process is swapped out and suspended until
+//	there is room for it again.  This keeps the others from thrashing.
+//
+//	Free frames are kept in two pools, one of them pre-zeroed.  A
+//	kernel thread, the pager, keeps the pools above a low watermark
+//	by evicting pages in the background, so that a page fault rarely
+//	has to write a dirty victim back before it can read its page in.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "copyright.h"
+#include "machine.h"
+#include "synch.h"
+#include "list.h"
+
+#define PFFThreshold	1000	// a fault within this many ticks of the
+				// previous one means the process needs
+				// more frames; a longer gap means it can
+				// give up the pages it did not touch
+
+#define PagerLowWater	8	// wake the pager when fewer frames are free
+#define PagerHighWater	16	// the pager evicts until this many are free
+#define PagerZeroFrames	8	// free frames the pager keeps zero-filled
+
+class AddrSpace;
+class SharedText;
+class MappedFile;
+
+// One entry per physical page frame.
+
+class FrameEntry {
+  public:
+    AddrSpace *space;		// address space using the frame, or
+    SharedText *text;		// the shared code it holds, or
+    MappedFile *mapped;		// the mapped file it holds a page of;
+				// all NULL if the frame is free
+    int vpn;			// virtual page held in the frame (page
+				// within the file, for a mapped file)
+    int age;			// reference history: one bit per timer
+				// sample, most recent in bit 7; the page
+				// is in the working set if it is non-zero
+    bool busy;			// being written back by the pager: no
+				// longer mapped, but still holding the
+				// page until the write completes
+};
+
+// The following class defines the frame table.  When both free pools
+// are empty, a victim is chosen with the clock algorithm over the use
+// bits of the owners' page tables.
+
+class FrameTable {
+  public:
+    FrameTable();			// Initialize, all frames free and
+					// zeroed, and start the pager
+    ~FrameTable();			// De-allocate the frame table
+
+    int AllocateFrame(AddrSpace *space, int vpn, bool zero);
+					// Return a frame to hold "vpn" of
+					// "space", evicting a victim if
+					// memory is full; if "zero", the
+					// frame is zero-filled
+    int AllocateTextFrame(SharedText *text, int vpn);
+					// Same, for a page of shared code
+    int AllocateMappedFrame(MappedFile *mapped, int page);
+					// Same, for a page of a mapped file
+    void FreeFrame(int frame);		// Return a frame to the free pool
+    void FreeAll(AddrSpace *space);	// Free every frame held by "space"
+    bool Reclaim(AddrSpace *space, int vpn, int frame);
+					// Give "frame" back to "vpn", if the
+					// pager is still writing it out
+
+    void Print();			// Print the owner of every frame
+
+    void AddSpace(AddrSpace *space);	// A process starts to compete
+					// for memory
+    void RemoveSpace(AddrSpace *space);	// A process is going away
+    void SampleReferences();		// Age the reference bits and
+					// re-estimate the working sets;
+					// called on timer interrupts
+    void Admit(AddrSpace *space);	// PFF control, on every page fault;
+					// may suspend the caller until its
+					// working set fits in memory
+
+    void Pager();			// Body of the pager thread
+
+    Lock *lock;				// held across a whole page fault,
+					// so that only one fault at a time
+					// moves frames around
+
+  private:
+    int FindVictim();			// Clock replacement
+    void Evict(int frame);		// Unmap the page in "frame",
+					// writing it back if dirty
+    int Resident(AddrSpace *space);	// Number of frames held by "space"
+    void Trim(AddrSpace *space);	// Free the frames "space" has not
+					// used since its last fault
+    void SetWorkingSet(AddrSpace *space, int size);
+    void Suspend(AddrSpace *space);	// Swap out "space" and sleep
+    void ResumeWaiting();		// Wake the suspended processes
+					// that fit in memory again
+    void Clean();			// Evict pages, writing the dirty
+					// ones back in batches
+    void ZeroFree();			// Refill the zeroed pool
+
+    FrameEntry frames[NumPhysPages];
+    int hand;				// clock hand
+
+    int freeFrames[NumPhysPages];	// free frames, contents unknown
+    int numFree;
+    int zeroFrames[NumPhysPages];	// free frames, zero-filled
+    int numZero;
+    Condition *pagerWork;		// signalled when the pools run low
+    Condition *cleaned;			// broadcast after each write-back
+
+    int totalWorkingSet;		// sum of the working sets of the
+					// processes that are not suspended
+    int activeSpaces;			// number of such processes
+    ThreadQueue suspended;		// threads suspended by Admit
+};
+
+#endif // FRAMETABLE_H
@@ -0,0 +1,269 @@
+// mappedfile.cc
+//	Routines to manage files mapped into user address spaces.
+//
+//	The frame of a mapped page belongs to the MappedFile, not to any
+//	address space.  A page fault in a mapped region maps that frame;
+//	the frame table asks the MappedFile whether the page has been
+//	referenced, and to evict it, which unmaps it from every mapper
+//	and writes it back if any of their dirty bits is set.
+//
+//	Pages past the end of the file read as zeroes, and stores to them
+//	are not written back: the file never grows through a mapping.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "mappedfile.h"
+#include "addrspace.h"
+#include "system.h"
+
+MappedFile *MappedFile::table[MaxMappedFiles];
+
+//----------------------------------------------------------------------
+// MappedFile::Map
+// 	Map pages of a file into an address space.  If some process has
+//	the file mapped already, share its pages.
+//
+//	"file" is the file, as opened by the user
+//	"space" is the address space to map it into
+//	"firstVpn" is the virtual page where the mapping starts
+//	"firstPage", "numPages" are the file pages to map
+//----------------------------------------------------------------------
+
+MappedFile *
+MappedFile::Map(OpenFile *file, AddrSpace *space, int firstVpn,
+	int firstPage, int numPages)
+{
+    int key = file->HeaderSector();
+    MappedFile *mapped = NULL;
+    int slot = -1, i;
+
+    for (i = 0; i < MaxMappedFiles; i++) {
+	if (table[i] == NULL) {
+	    if (slot == -1)
+		slot = i;
+	} else if (table[i]->key == key)
+	    mapped = table[i];
+    }
+    if (mapped == NULL) {
+	if (slot == -1)
+	    return NULL;
+	mapped = table[slot] = new MappedFile(file, key);
+    }
+
+    if (firstPage + numPages > mapped->numPages) {
+	int *oldFrames = mapped->frames;
+	bool *oldDirty = mapped->dirty;
+
+	mapped->frames = new int[firstPage + numPages];
+	mapped->dirty = new bool[firstPage + numPages];
+	for (i = 0; i < firstPage + numPages; i++) {
+	    mapped->frames[i] = (i < mapped->numPages) ? oldFrames[i] : -1;
+	    mapped->dirty[i] = (i < mapped->numPages) ? oldDirty[i] : FALSE;
+	}
+	delete [] oldFrames;
+	delete [] oldDirty;
+	mapped->numPages = firstPage + numPages;
+    }
+
+    if (mapped->numMappings == mapped->maxMappings) {
+	Mapping *old = mapped->mappings;
+
+	mapped->maxMappings *= 2;
+	mapped->mappings = new Mapping[mapped->maxMappings];
+	for (i = 0; i < mapped->numMappings; i++)
+	    mapped->mappings[i] = old[i];
+	delete [] old;
+    }
+    i = mapped->numMappings++;
+    mapped->mappings[i].space = space;
+    mapped->mappings[i].firstVpn = firstVpn;
+    mapped->mappings[i].firstPage = firstPage;
+    mapped->mappings[i].numPages = numPages;
+    DEBUG('a', "Mapped pages %d-%d of file %d at vpn %d\n", firstPage,
+	firstPage + numPages - 1, key, firstVpn);
+    return mapped;
+}
+
+//----------------------------------------------------------------------
+// MappedFile::MappedFile
+// 	Start tracking a mapped file.  We keep a handle of our own, so the
+//	user may close the file while it is mapped.
+//----------------------------------------------------------------------
+
+MappedFile::MappedFile(OpenFile *userFile, int fileKey)
+{
+    key = fileKey;
+    file = userFile->Reopen();
+    numPages = 0;
+    frames = NULL;
+    dirty = NULL;
+    maxMappings = 2;
+    mappings = new Mapping[maxMappings];
+    numMappings = 0;
+}
+
+//----------------------------------------------------------------------
+// MappedFile::~MappedFile
+// 	Stop tracking a file nobody has mapped any more.
+//----------------------------------------------------------------------
+
+MappedFile::~MappedFile()
+{
+    delete [] frames;
+    delete [] dirty;
+    delete [] mappings;
+    delete file;
+}
+
+//----------------------------------------------------------------------
+// MappedFile::Unmap
+// 	Remove a mapping.  The dirty bits of its page table entries are
+//	remembered, so the pages are written back later even though this
+//	address space no longer maps them.  When the last mapping goes,
+//	every page in memory is written back (if dirty) and freed.
+//
+//	"space", "firstVpn" identify the mapping
+//----------------------------------------------------------------------
+
+void
+MappedFile::Unmap(AddrSpace *space, int firstVpn)
+{
+    TranslationEntry *entry;
+    Mapping *m;
+    int i, page;
+
+    for (i = 0; i < numMappings; i++)
+	if (mappings[i].space == space && mappings[i].firstVpn == firstVpn)
+	    break;
+    ASSERT(i < numMappings);
+    m = &mappings[i];
+    for (page = m->firstPage; page < m->firstPage + m->numPages; page++) {
+	entry = space->PageEntry(m->firstVpn + page - m->firstPage);
+	if (entry != NULL && entry->valid && space->Unmap(entry->virtualPage))
+	    dirty[page] = TRUE;
+    }
+    mappings[i] = mappings[--numMappings];
+    if (numMappings > 0)
+	return;
+
+    DEBUG('a', "Last mapping of file %d is gone\n", key);
+    for (page = 0; page < numPages; page++)
+	if (frames[page] != -1) {
+	    if (dirty[page])
+		WriteBack(page);
+	    frameTable->FreeFrame(frames[page]);
+	}
+    for (i = 0; i < MaxMappedFiles; i++)
+	if (table[i] == this)
+	    table[i] = NULL;
+    delete this;
+}
+
+//----------------------------------------------------------------------
+// MappedFile::Fault
+// 	Return the frame holding a page of the file, allocating one and
+//	reading the page in if nobody has it in memory.
+//
+//	"page" is the page number within the file
+//----------------------------------------------------------------------
+
+int
+MappedFile::Fault(int page)
+{
+    int frame, numRead;
+    char *data;
+
+    ASSERT(page >= 0 && page < numPages);
+    if (frames[page] == -1) {
+	frame = frameTable->AllocateMappedFrame(this, page);
+	data = &machine->mainMemory[frame * PageSize];
+	numRead = file->ReadAt(data, PageSize, page * PageSize);
+	if (numRead < 0)
+	    numRead = 0;
+	if (numRead < PageSize)		// past the end of the file
+	    bzero(data + numRead, PageSize - numRead);
+	frames[page] = frame;
+	dirty[page] = FALSE;
+	DEBUG('a', "File %d page %d read into frame %d\n", key, page, frame);
+    }
+    return frames[page];
+}
+
+//----------------------------------------------------------------------
+// MappedFile::Referenced
+// 	Return TRUE if any mapper has referenced a page since the last
+//	call, and clear the use bits.  Used by the clock algorithm.
+//----------------------------------------------------------------------
+
+bool
+MappedFile::Referenced(int page)
+{
+    TranslationEntry *entry;
+    Mapping *m;
+    bool used = FALSE;
+
+    for (int i = 0; i < numMappings; i++) {
+	m = &mappings[i];
+	if (page < m->firstPage || page >= m->firstPage + m->numPages)
+	    continue;
+	entry = m->space->PageEntry(m->firstVpn + page - m->firstPage);
+	if (entry != NULL && entry->valid && entry->use) {
+	    used = TRUE;
+	    entry->use = FALSE;
+	}
+    }
+    return used;
+}
+
+//----------------------------------------------------------------------
+// MappedFile::Evict
+// 	Unmap a page from every mapper, and write it back to the file if
+//	any of them modified it.  The caller frees the frame.
+//----------------------------------------------------------------------
+
+void
+MappedFile::Evict(int page)
+{
+    TranslationEntry *entry;
+    Mapping *m;
+    int vpn;
+
+    ASSERT(frames[page] != -1);
+    for (int i = 0; i < numMappings; i++) {
+	m = &mappings[i];
+	if (page < m->firstPage || page >= m->firstPage + m->numPages)
+	    continue;
+	vpn = m->firstVpn + page - m->firstPage;
+	entry = m->space->PageEntry(vpn);
+	if (entry != NULL && entry->valid && m->space->Unmap(vpn))
+	    dirty[page] = TRUE;
+    }
+    if (dirty[page])
+	WriteBack(page);
+    frames[page] = -1;
+    dirty[page] = FALSE;
+}
+
+//----------------------------------------------------------------------
+// MappedFile::WriteBack
+// 	Write a page back to the file, but not the part of it past the
+//	end of the file.
+//----------------------------------------------------------------------
+
+void
+MappedFile::WriteBack(int page)
+{
+    int length = file->Length() - page * PageSize;
+
+    if (length > PageSize)
+	length = PageSize;
+    if (length <= 0)
+	return;
+    DEBUG('a', "Writing back page %d of file %d\n", page, key);
+    file->WriteAt(&machine->mainMemory[frames[page] * PageSize], length,
+	page * PageSize);
+    imageCache->Invalidate(key);
+}
@@ -0,0 +1,80 @@
+// mappedfile.h
+//	Data structures for files mapped into the address spaces of user
+//	programs (the Mmap system call).
+//
+//	A MappedFile holds the pages of one file that are in memory, no
+//	matter how many processes have it mapped, or where: all of them
+//	map the same frames, so a store by one is seen by the others.
+//	Pages are read from the file when first touched, and written back
+//	to it when they are evicted or unmapped, if any mapper dirtied
+//	them.  Files are identified by the sector of their header.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "copyright.h"
+#include "openfile.h"
+
+#define MaxMappedFiles	16	// files that can be mapped at one time
+
+class AddrSpace;
+
+// One mapping of (part of) the file into an address space: file page
+// "firstPage + i" appears at virtual page "firstVpn + i".
+
+class Mapping {
+  public:
+    AddrSpace *space;
+    int firstVpn;
+    int firstPage;
+    int numPages;
+};
+
+// The following class defines a file mapped by one or more address
+// spaces.  The frame table lock must be held to use it.
+
+class MappedFile {
+  public:
+    static MappedFile *Map(OpenFile *file, AddrSpace *space, int firstVpn,
+			int firstPage, int numPages);
+					// Map pages of "file" into "space";
+					// NULL if too many files are mapped
+    void Unmap(AddrSpace *space, int firstVpn);
+					// Remove a mapping, writing back
+					// the pages it dirtied; the last
+					// one deletes the MappedFile
+
+    int Fault(int page);		// Return the frame holding file
+					// page "page", reading it in if
+					// needed
+    bool Referenced(int page);		// Has any mapper touched "page"
+					// since the last call?
+    void Evict(int page);		// Unmap "page" everywhere, and write
+					// it back if dirty; the frame table
+					// frees the frame
+
+  private:
+    MappedFile(OpenFile *file, int key);
+    ~MappedFile();
+
+    void WriteBack(int page);		// Write a page back to the file
+
+    int key;				// header sector of the file
+    OpenFile *file;			// our own handle on the file
+    int numPages;			// pages tracked, grows with the
+					// mappings
+    int *frames;			// frame of each page, -1 if the
+					// page is not in memory
+    bool *dirty;			// modified by some mapper that has
+					// given up its mapping since
+    Mapping *mappings;
+    int numMappings, maxMappings;
+
+    static MappedFile *table[MaxMappedFiles];
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,108 @@
+// pagetable.cc
+//	Routines to manage a two-level page table.
+//
+//	The directory is allocated up front (one pointer per PageTableChunk
+//	virtual pages); second level tables are allocated lazily by Fetch,
+//	the first time a page they cover is faulted in.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pagetable.h"
+
+//----------------------------------------------------------------------
+// PageTable::PageTable
+// 	Initialize an empty page table.  No second level tables are
+//	allocated until some page is touched.
+//
+//	"size" is the number of virtual pages the table must be able to map
+//----------------------------------------------------------------------
+
+PageTable::PageTable(int size)
+{
+    numPages = size;
+    numChunks = 0;
+    dirSize = divRoundUp(size, PageTableChunk);
+    directory = new TranslationEntry*[dirSize];
+    for (int i = 0; i < dirSize; i++)
+	directory[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// PageTable::~PageTable
+// 	De-allocate the directory and every second level table.
+//----------------------------------------------------------------------
+
+PageTable::~PageTable()
+{
+    for (int i = 0; i < dirSize; i++)
+	if (directory[i] != NULL)
+	    delete [] directory[i];
+    delete [] directory;
+}
+
+//----------------------------------------------------------------------
+// PageTable::Fetch
+// 	Return the translation entry for a virtual page, allocating the
+//	second level table that covers it if this is the first page of
+//	the chunk to be touched.  Freshly allocated entries are invalid.
+//
+//	"vpn" is the virtual page number
+//----------------------------------------------------------------------
+
+TranslationEntry *
+PageTable::Fetch(int vpn)
+{
+    TranslationEntry *chunk;
+    int base;
+
+    ASSERT(vpn >= 0 && vpn < numPages);
+    chunk = directory[vpn / PageTableChunk];
+    if (chunk == NULL) {
+	DEBUG('a', "Allocating page table chunk for vpn %d\n", vpn);
+	chunk = new TranslationEntry[PageTableChunk];
+	base = (vpn / PageTableChunk) * PageTableChunk;
+	for (int i = 0; i < PageTableChunk; i++) {
+	    chunk[i].virtualPage = base + i;
+	    chunk[i].physicalPage = -1;
+	    chunk[i].valid = FALSE;
+	    chunk[i].readOnly = FALSE;
+	    chunk[i].use = FALSE;
+	    chunk[i].dirty = FALSE;
+	    chunk[i].shared = FALSE;
+	    chunk[i].cnt = 0;
+	}
+	directory[vpn / PageTableChunk] = chunk;
+	numChunks++;
+    }
+    return &chunk[vpn % PageTableChunk];
+}
+
+//----------------------------------------------------------------------
+// PageTable::Grow
+// 	Extend the range of virtual pages the table can map.  Only the
+//	directory may need to be enlarged; the new pages are invalid
+//	until they are touched.
+//
+//	"size" is the new number of virtual pages
+//----------------------------------------------------------------------
+
+void
+PageTable::Grow(int size)
+{
+    int newDirSize = divRoundUp(size, PageTableChunk);
+    TranslationEntry **newDirectory;
+
+    ASSERT(size >= numPages);
+    if (newDirSize > dirSize) {
+	newDirectory = new TranslationEntry*[newDirSize];
+	for (int i = 0; i < newDirSize; i++)
+	    newDirectory[i] = (i < dirSize) ? directory[i] : NULL;
+	delete [] directory;
+	directory = newDirectory;
+	dirSize = newDirSize;
+    }
+    numPages = size;
+}
@@ -0,0 +1,62 @@
+// pagetable.h
+//	Data structures for a two-level page table, used to translate the
+//	virtual pages of one address space into physical page frames.
+//
+//	The top level (the "directory") holds one pointer for every
+//	PageTableChunk virtual pages.  A second level table -- an array
+//	of PageTableChunk translation entries -- is only allocated the
+//	first time one of its pages is touched, so the memory used by the
+//	table is proportional to the number of pages actually referenced,
+//	not to the size of the virtual address space.  A lookup is just
+//	two array indexings.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGETABLE_H
+#define PAGETABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "translate.h"
+
+#define PageTableChunk	32	// number of virtual pages covered by
+				// one second level table
+
+// The following class defines a two-level page table covering the
+// virtual pages [0, numPages).
+
+class PageTable {
+  public:
+    PageTable(int numPages);		// Create an empty page table, able
+					// to map "numPages" virtual pages
+    ~PageTable();			// De-allocate the page table
+
+    TranslationEntry *Lookup(int vpn) {	// Return the entry for "vpn", or
+	TranslationEntry *chunk;	// NULL if no page in its chunk
+					// has been touched yet
+	if (vpn < 0 || vpn >= numPages)
+	    return NULL;
+	chunk = directory[vpn / PageTableChunk];
+	if (chunk == NULL)
+	    return NULL;
+	return &chunk[vpn % PageTableChunk];
+    }
+
+    TranslationEntry *Fetch(int vpn);	// Like Lookup, but allocate the
+					// second level table if needed
+    void Grow(int size);		// Extend the table to map "size"
+					// virtual pages
+
+    int NumPages() { return numPages; }
+    int NumChunks() { return numChunks; } // second level tables allocated
+
+  private:
+    TranslationEntry **directory;	// top level, one slot per chunk
+    int dirSize;			// number of slots in the directory
+    int numPages;			// number of virtual pages covered
+    int numChunks;			// number of second level tables
+};
+
+#endif // PAGETABLE_H
@@ -0,0 +1,144 @@
+// pipe.cc
+//	Routines to move data through pipes.
+//
+//	Each transfer copies the largest piece that is contiguous in the
+//	ring buffer directly to or from the user buffer; AddrSpace::CopyIn
+//	and CopyOut split it at page boundaries, and page in the user
+//	pages as needed.  A reader takes whatever is there, as soon as
+//	there is something; a writer keeps going until all of its data is
+//	in the pipe.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pipe.h"
+#include "addrspace.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// PipeBuffer::PipeBuffer
+// 	Initialize an empty pipe, with both ends open.
+//----------------------------------------------------------------------
+
+PipeBuffer::PipeBuffer()
+{
+    head = count = 0;
+    readerOpen = writerOpen = TRUE;
+    lock = new Lock("pipe");
+    notEmpty = new Condition("pipe not empty");
+    notFull = new Condition("pipe not full");
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::~PipeBuffer
+// 	De-allocate a pipe, once both ends are closed.
+//----------------------------------------------------------------------
+
+PipeBuffer::~PipeBuffer()
+{
+    delete notFull;
+    delete notEmpty;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Read
+// 	Move data from the pipe into user memory.  Wait while the pipe is
+//	empty, unless the write end is closed, in which case this is the
+//	end of the data.
+//
+//	"space" is the address space of the reader
+//	"addr", "size" are the user buffer
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Read(AddrSpace *space, int addr, int size)
+{
+    int done = 0, piece;
+
+    lock->Acquire();
+    while (count == 0 && writerOpen)
+	notEmpty->Wait(lock);
+    while (done < size && count > 0) {
+	piece = min(size - done, min(count, PipeSize - head));
+	if (!space->CopyOut(addr + done, &buffer[head], piece)) {
+	    done = -1;
+	    break;
+	}
+	head = (head + piece) % PipeSize;
+	count -= piece;
+	done += piece;
+    }
+    if (done != 0)
+	notFull->Broadcast(lock);	// there may be room for several
+    lock->Release();
+    DEBUG('c', "Read %d bytes from a pipe\n", done);
+    return done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Write
+// 	Move data from user memory into the pipe, waiting for room
+//	whenever it is full.  If the read end is closed, nobody will ever
+//	read the data, so give up.
+//
+//	"space" is the address space of the writer
+//	"addr", "size" are the user buffer
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Write(AddrSpace *space, int addr, int size)
+{
+    int done = 0, tail, piece;
+
+    lock->Acquire();
+    while (done < size) {
+	while (count == PipeSize && readerOpen)
+	    notFull->Wait(lock);
+	if (!readerOpen) {
+	    done = -1;
+	    break;
+	}
+	tail = (head + count) % PipeSize;
+	piece = min(size - done, min(PipeSize - count, PipeSize - tail));
+	if (!space->CopyIn(addr + done, &buffer[tail], piece)) {
+	    done = -1;
+	    break;
+	}
+	count += piece;
+	done += piece;
+	notEmpty->Signal(lock);
+    }
+    lock->Release();
+    DEBUG('c', "Wrote %d bytes to a pipe\n", done);
+    return done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Close
+// 	Close one end of the pipe, and wake up whoever is waiting at the
+//	other end, so it can see it.  Returns TRUE once both ends are
+//	closed; the caller then deletes the pipe.
+//
+//	"writeEnd" is TRUE for the write end, FALSE for the read end
+//----------------------------------------------------------------------
+
+bool
+PipeBuffer::Close(bool writeEnd)
+{
+    bool unused;
+
+    lock->Acquire();
+    if (writeEnd) {
+	writerOpen = FALSE;
+	notEmpty->Broadcast(lock);
+    } else {
+	readerOpen = FALSE;
+	notFull->Broadcast(lock);
+    }
+    unused = !readerOpen && !writerOpen;
+    lock->Release();
+    return unused;
+}
@@ -0,0 +1,63 @@
+// pipe.h
+//	Data structures for pipes between user processes.
+//
+//	A pipe is a bounded buffer in kernel memory, with a read end and a
+//	write end.  Data is copied straight from the writer's address
+//	space into the buffer, and from the buffer into the reader's, a
+//	page at a time; nothing goes through the file system.  A reader
+//	blocks while the pipe is empty, and a writer while it is full.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "copyright.h"
+#include "synch.h"
+
+#define PipeSize	1024	// bytes a pipe can hold
+
+class AddrSpace;
+
+// The following class defines a pipe (named so as not to clash with
+// the Pipe system call), as a ring buffer: "count" bytes of data start
+// at "head", wrapping around the end of "buffer".  A new pipe has one
+// read end and one write end open.
+
+class PipeBuffer {
+  public:
+    PipeBuffer();			// Initialize an empty pipe
+    ~PipeBuffer();
+
+    int Read(AddrSpace *space, int addr, int size);
+					// Read up to "size" bytes into user
+					// memory, waiting for some if the
+					// pipe is empty.  Returns the number
+					// read: 0 once all writers are gone,
+					// -1 if "addr" is bad
+    int Write(AddrSpace *space, int addr, int size);
+					// Write "size" bytes from user
+					// memory, waiting for room as
+					// needed.  Returns the number
+					// written, or -1 if no reader is
+					// left or "addr" is bad
+
+    bool Close(bool writeEnd);		// Close an end; TRUE if both ends
+					// are closed, and the pipe can go
+
+  private:
+    char buffer[PipeSize];
+    int head;				// where the next byte is read from
+    int count;				// number of bytes in the pipe
+    bool readerOpen, writerOpen;	// which ends are still open
+
+    Lock *lock;
+    Condition *notEmpty;		// signalled when data is added, or
+					// the write end is closed
+    Condition *notFull;			// signalled when data is removed, or
+					// the read end is closed
+};
+
+#endif // PIPE_H
@@ -0,0 +1,401 @@
+// process.cc
+//	Routines to create, wait for, and clean up user processes.
+//
+//	A process exits when its last thread is done, whether that thread
+//	calls Exit or ThreadExit; its exit status is that of the last call
+//	to Exit, if any thread made one, and 0 otherwise.
+//
+//	Each process keeps a doubly linked list of its children, so that
+//	a child can be unlinked in constant time when it is joined, and
+//	has a condition variable of its own that its parent waits on in
+//	Join.  Exit signals only that condition, so it wakes only the
+//	parent of the exiting process, however many processes are waiting
+//	for their own children.
+//
+//	A process that exits while its parent is alive becomes a zombie:
+//	its control block is kept, for its exit status, until the parent
+//	joins with it or exits itself.  The children of an exiting process
+//	are orphaned; nobody can join with them, so they are deleted as
+//	soon as they exit.
+//
+//	A new process gets the open descriptors of its parent, shared, as
+//	after a UNIX fork; this is how a shell hands a pipe to the two
+//	programs it connects.  A process that exits closes its own.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "process.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Process::Process
+// 	Initialize a process control block.
+//
+//	"pid" is the process id
+//	"parent" is the process that created this one
+//----------------------------------------------------------------------
+
+Process::Process(int id, Process *parentProcess)
+{
+    pid = id;
+    parent = parentProcess;
+    initial = (parentProcess == NULL);
+    children = prevSibling = nextSibling = NULL;
+    numThreads = 1;
+    exited = FALSE;
+    exitStatus = 0;
+    exitCond = new Condition("process exit");
+    joining = FALSE;
+    for (int i = 0; i < MaxUserLocks; i++)
+	locks[i] = NULL;
+    for (int i = 0; i < MaxUserConds; i++)
+	conds[i] = NULL;
+    for (int fd = 0; fd < MaxOpenFiles; fd++)
+	fds[fd] = NULL;
+    ring = -1;
+    upcall = upcallExit = -1;
+    hashNext = NULL;
+}
+
+//----------------------------------------------------------------------
+// Process::~Process
+// 	De-allocate a process control block, and the synchronization
+//	objects its threads did not destroy.
+//----------------------------------------------------------------------
+
+Process::~Process()
+{
+    for (int i = 0; i < MaxUserLocks; i++)
+	delete locks[i];
+    for (int i = 0; i < MaxUserConds; i++)
+	delete conds[i];
+    delete exitCond;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize the process table, empty.  Process ids start at 1, so
+//	that 0 can mean failure to Exec and Fork.
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable()
+{
+    lock = new Lock("process table");
+    for (int i = 0; i < PidBuckets; i++)
+	buckets[i] = NULL;
+    nextPid = 1;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::~ProcessTable
+// 	De-allocate the process table, and any processes left in it.
+//----------------------------------------------------------------------
+
+ProcessTable::~ProcessTable()
+{
+    Process *process;
+
+    for (int i = 0; i < PidBuckets; i++)
+	while ((process = buckets[i]) != NULL) {
+	    buckets[i] = process->hashNext;
+	    delete process;
+	}
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Lookup
+// 	Find a process by its id.  The caller must hold the lock.
+//----------------------------------------------------------------------
+
+Process *
+ProcessTable::Lookup(int pid)
+{
+    Process *process;
+
+    for (process = buckets[pid % PidBuckets]; process != NULL;
+		process = process->hashNext)
+	if (process->pid == pid)
+	    return process;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Create
+// 	Make a new process, with a process id no other process is using,
+//	and add it to the children of its parent.
+//
+//	"parent" is the creating process, NULL for the first one
+//----------------------------------------------------------------------
+
+Process *
+ProcessTable::Create(Process *parent)
+{
+    Process *process;
+    int pid;
+
+    lock->Acquire();
+    do {
+	pid = nextPid;
+	nextPid = (nextPid == 0x7fffffff) ? 1 : nextPid + 1;
+    } while (Lookup(pid) != NULL);
+
+    process = new Process(pid, parent);
+    process->hashNext = buckets[pid % PidBuckets];
+    buckets[pid % PidBuckets] = process;
+    if (parent != NULL) {
+	process->nextSibling = parent->children;
+	if (parent->children != NULL)
+	    parent->children->prevSibling = process;
+	parent->children = process;
+	for (int fd = 0; fd < MaxOpenFiles; fd++)
+	    if ((process->fds[fd] = parent->fds[fd]) != NULL)
+		process->fds[fd]->refCount++;
+    }
+    lock->Release();
+    DEBUG('c', "Created process %d\n", pid);
+    return process;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::AddThread
+// 	Count a new thread of a process, made by ThreadCreate.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::AddThread(Process *process)
+{
+    lock->Acquire();
+    process->numThreads++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Exit
+// 	A thread of a process calls Exit: record the exit status, and end
+//	the thread.  Returns TRUE if the first process is over.
+//
+//	"process" is the exiting process
+//	"status" is its exit status
+//----------------------------------------------------------------------
+
+bool
+ProcessTable::Exit(Process *process, int status)
+{
+    bool over;
+
+    lock->Acquire();
+    process->exitStatus = status;
+    over = ThreadDone(process);
+    lock->Release();
+    return over;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ThreadExit
+// 	A thread of a process is done.  Returns TRUE if the first process
+//	is over.
+//----------------------------------------------------------------------
+
+bool
+ProcessTable::ThreadExit(Process *process)
+{
+    bool over;
+
+    lock->Acquire();
+    over = ThreadDone(process);
+    lock->Release();
+    return over;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ThreadDone
+// 	Count the end of a thread.  When it is the last one, the process
+//	exits: wake up its parent if it is waiting in Join.  The process's
+//	own children are orphaned; the ones that have exited already are
+//	deleted.  If the process has no parent left to join with it, it is
+//	deleted too.  The caller must hold the lock.
+//
+//	Returns TRUE if the process is the first one, and it is over.
+//----------------------------------------------------------------------
+
+bool
+ProcessTable::ThreadDone(Process *process)
+{
+    Process *child, *next;
+    bool initial = process->initial;
+
+    if (--process->numThreads > 0)
+	return FALSE;
+    DEBUG('c', "Process %d exits, status %d\n", process->pid,
+	process->exitStatus);
+    process->exited = TRUE;
+    for (int fd = 0; fd < MaxOpenFiles; fd++)
+	if (process->fds[fd] != NULL) {
+	    Release(process->fds[fd]);
+	    process->fds[fd] = NULL;
+	}
+    for (child = process->children; child != NULL; child = next) {
+	next = child->nextSibling;
+	child->parent = NULL;
+	child->prevSibling = child->nextSibling = NULL;
+	if (child->exited)
+	    Remove(child);
+    }
+    process->children = NULL;
+
+    if (process->parent == NULL)
+	Remove(process);
+    else
+	process->exitCond->Signal(lock);
+    return initial;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Join
+// 	Wait for a child process to exit, and return its exit status.
+//	The child is deleted; its process id may be reused.  Only one
+//	thread of the parent may wait for a given child: another one
+//	would wake up to find the child deleted.
+//
+//	"parent" is the calling process
+//	"pid" is the child to wait for
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Join(Process *parent, int pid)
+{
+    Process *child;
+    int status;
+
+    lock->Acquire();
+    child = Lookup(pid);
+    if (child == NULL || child->parent != parent || child->joining) {
+	lock->Release();
+	return -1;
+    }
+    child->joining = TRUE;
+    while (!child->exited)
+	child->exitCond->Wait(lock);
+    status = child->exitStatus;
+    Remove(child);
+    lock->Release();
+    return status;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::AddDescriptor
+// 	Put a new descriptor in the lowest free slot of the descriptor
+//	table of a process.  0 and 1 are left for the console.
+//
+//	"file" is the open file, or NULL for
+//	"pipe", with "writeEnd" telling which end
+//----------------------------------------------------------------------
+
+int
+ProcessTable::AddDescriptor(Process *process, OpenFile *file,
+	PipeBuffer *pipe, bool writeEnd)
+{
+    Descriptor *descriptor;
+    int fd;
+
+    lock->Acquire();
+    for (fd = 2; fd < MaxOpenFiles; fd++)
+	if (process->fds[fd] == NULL)
+	    break;
+    if (fd < MaxOpenFiles) {
+	descriptor = new Descriptor;
+	descriptor->file = file;
+	descriptor->pipe = pipe;
+	descriptor->writeEnd = writeEnd;
+	descriptor->refCount = 1;
+	process->fds[fd] = descriptor;
+    } else
+	fd = -1;
+    lock->Release();
+    return fd;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::FindDescriptor
+// 	Return the descriptor of an open file id, or NULL if it is not
+//	open.
+//----------------------------------------------------------------------
+
+Descriptor *
+ProcessTable::FindDescriptor(Process *process, int fd)
+{
+    if (fd < 0 || fd >= MaxOpenFiles)
+	return NULL;
+    return process->fds[fd];
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Close
+// 	Close an open file id of a process.  Returns 0, or -1 if it was
+//	not open.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Close(Process *process, int fd)
+{
+    if (fd < 0 || fd >= MaxOpenFiles)
+	return -1;
+    lock->Acquire();
+    if (process->fds[fd] == NULL) {
+	lock->Release();
+	return -1;
+    }
+    Release(process->fds[fd]);
+    process->fds[fd] = NULL;
+    lock->Release();
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Release
+// 	Drop a reference to a descriptor.  When no process has it open
+//	any more, close the file or the pipe end.  The caller must hold
+//	the lock.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Release(Descriptor *descriptor)
+{
+    if (--descriptor->refCount > 0)
+	return;
+    if (descriptor->file != NULL)
+	delete descriptor->file;
+    else if (descriptor->pipe->Close(descriptor->writeEnd))
+	delete descriptor->pipe;
+    delete descriptor;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Remove
+// 	Take a process out of the list of children of its parent and out
+//	of the hash table, and delete it.  The caller must hold the lock.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Remove(Process *process)
+{
+    Process **link;
+
+    if (process->parent != NULL) {
+	if (process->prevSibling != NULL)
+	    process->prevSibling->nextSibling = process->nextSibling;
+	else
+	    process->parent->children = process->nextSibling;
+	if (process->nextSibling != NULL)
+	    process->nextSibling->prevSibling = process->prevSibling;
+    }
+    for (link = &buckets[process->pid % PidBuckets]; *link != process;
+		link = &(*link)->hashNext)
+	ASSERT(*link != NULL);
+    *link = process->hashNext;
+    delete process;
+}
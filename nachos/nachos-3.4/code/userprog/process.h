@@ -0,0 +1,129 @@
+// process.h
+//	Data structures to keep track of user processes.
+//
+//	A process is a user program running in an address space, as
+//	started by Exec or Fork.  Its process control block lives apart
+//	from the thread running it, so that it survives the thread: when
+//	a process exits, its exit status is kept until its parent joins
+//	with it.  Processes are named by a process id (the SpaceId of the
+//	system call interface), and found through a hash table.
+//
+//	A process may run several threads, all in its address space; it
+//	exits when the last of them is done.  The locks and condition
+//	variables its threads use to synchronize are kept here too, as is
+//	its table of open file descriptors, which a child process inherits
+//	from its parent.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include "copyright.h"
+#include "synch.h"
+#include "filesys.h"
+#include "pipe.h"
+
+#define PidBuckets	64	// size of the process id hash table
+#define MaxUserLocks	16	// locks a process can create
+#define MaxUserConds	16	// condition variables a process can create
+#define MaxOpenFiles	16	// file descriptors per process; 0 and 1
+				// are the console (see syscall.h)
+
+// An open file, or one end of a pipe, as seen by user programs.  It is
+// shared by the processes that inherited it, and closed when the last
+// of them closes it.
+
+class Descriptor {
+  public:
+    OpenFile *file;			// the open file, or NULL for
+    PipeBuffer *pipe;			// one end of this pipe
+    bool writeEnd;			// TRUE for the write end
+    int refCount;			// processes using the descriptor
+};
+
+// The following class defines a process control block.  The fields
+// are protected by the lock of the process table.
+
+class Process {
+  public:
+    Process(int pid, Process *parent);	// Initialize a process control
+					// block, with no children
+    ~Process();
+
+    int pid;				// process id
+    Process *parent;			// NULL once the parent has exited,
+					// and for the first process
+    bool initial;			// the first process; the machine
+					// halts when it exits
+    Process *children;			// first child, linked through
+    Process *prevSibling, *nextSibling;	// the children's sibling pointers
+
+    int numThreads;			// threads still running
+    bool exited;			// all threads are done; the block
+    int exitStatus;			// stays until the parent joins
+    Condition *exitCond;		// signalled when the process exits
+    bool joining;			// a thread of the parent is waiting
+					// in Join; no other may join
+
+    Lock *locks[MaxUserLocks];		// user locks, by id; NULL if free
+    Condition *conds[MaxUserConds];	// user condition variables, by id
+    Descriptor *fds[MaxOpenFiles];	// open files, by OpenFileId
+    int ring;				// user address of the submission
+					// ring (see syscall.h), -1 if none
+    int upcall;				// user procedure to call when a
+					// thread blocks, -1 if none
+    int upcallExit;			// where the upcall returns to
+
+    Process *hashNext;			// next process in the hash bucket
+};
+
+// The following class defines the table of all processes, whether
+// running or exited but not yet joined.
+
+class ProcessTable {
+  public:
+    ProcessTable();			// Initialize, with no processes
+    ~ProcessTable();
+
+    Process *Create(Process *parent);	// Make a new process, a child of
+					// "parent" (NULL for the first one),
+					// with one thread
+    void AddThread(Process *process);	// The process has one more thread
+    bool Exit(Process *process, int status);
+					// A thread calls Exit: set the exit
+					// status, and end the thread
+    bool ThreadExit(Process *process);	// End a thread of the process; the
+					// last one wakes up the parent if it
+					// is waiting.  Both return TRUE if
+					// the first process is over
+    int Join(Process *parent, int pid);	// Wait for child "pid" of "parent"
+					// to exit, and return its status;
+					// -1 if there is no such child
+    Process *Lookup(int pid);		// Find a process by id, or NULL
+
+    int AddDescriptor(Process *process, OpenFile *file,
+			PipeBuffer *pipe, bool writeEnd);	// Give the process a descriptor for
+					// a file, or a pipe end; return it,
+					// or -1 if the table is full
+    Descriptor *FindDescriptor(Process *process, int fd);
+					// Descriptor "fd", or NULL
+    int Close(Process *process, int fd);
+					// Close "fd"; 0, or -1 if not open
+
+  private:
+    bool ThreadDone(Process *process);	// ThreadExit, with the lock held
+    void Release(Descriptor *descriptor);
+					// A process is done with a
+					// descriptor; the last one closes it
+    void Remove(Process *process);	// Unlink a process from its parent
+					// and the hash table, and delete it
+
+    Lock *lock;
+    Process *buckets[PidBuckets];	// hash table of processes by pid
+    int nextPid;			// next process id to try
+};
+
+#endif // PROCESS_H
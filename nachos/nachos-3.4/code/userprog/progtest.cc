@@ -58,6 +58,7 @@ StartProcess(char *filename)
     }
     space = new AddrSpace(executable);    
     currentThread->space = space;
+    currentThread->process = processTable->Create(NULL);
 
     delete executable;			// close file
 
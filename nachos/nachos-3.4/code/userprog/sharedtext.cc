@@ -0,0 +1,217 @@
+// sharedtext.cc
+//	Routines to share the code pages of an executable between the
+//	address spaces running it.
+//
+//	The shared texts in use are kept in a small table, looked up by
+//	the image of the executable.  A page fault on a code page maps
+//	the frame of the shared text, read-only, reading the page from
+//	the backing file first if no other process has it in memory.
+//	The frame table owns the frames; it asks the shared text whether
+//	a page has been referenced (by any user), and to unmap it from
+//	all of its users when the page is evicted.  Code pages are never
+//	dirty, so they are simply dropped.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "sharedtext.h"
+#include "addrspace.h"
+#include "system.h"
+#include <stdio.h>
+
+SharedText *SharedText::table[MaxSharedTexts];
+int SharedText::nextId = 0;
+
+//----------------------------------------------------------------------
+// SharedText::Attach
+// 	Return the shared text of an executable.  If no process is running
+//	it yet, create it.  Returns NULL if the table is full; the caller
+//	then keeps a private copy of its code.
+//
+//	"image" is the image of the executable the process is loaded from
+//	"firstPage", "numPages" are the virtual pages holding only code
+//----------------------------------------------------------------------
+
+SharedText *
+SharedText::Attach(ExecImage *image, int firstPage, int numPages)
+{
+    int slot = -1;
+
+    for (int i = 0; i < MaxSharedTexts; i++) {
+	if (table[i] == NULL) {
+	    if (slot == -1)
+		slot = i;
+	} else if (table[i]->image == image) {
+	    DEBUG('a', "Sharing text of file %d\n", image->key);
+	    return table[i];
+	}
+    }
+    if (slot == -1)
+	return NULL;
+    table[slot] = new SharedText(image, firstPage, numPages);
+    return table[slot];
+}
+
+//----------------------------------------------------------------------
+// SharedText::SharedText
+// 	Set up the shared text of an executable: copy its code pages into
+//	a backing file of their own, so they can be read in page by page
+//	once the executable is closed.  No page is in memory yet.
+//----------------------------------------------------------------------
+
+SharedText::SharedText(ExecImage *executable, int first, int count)
+{
+    int size = count * PageSize;
+
+    image = executable;
+    firstPage = first;
+    numPages = count;
+    frames = new int[numPages];
+    for (int i = 0; i < numPages; i++)
+	frames[i] = -1;
+    maxUsers = 4;
+    users = new AddrSpace*[maxUsers];
+    numUsers = 0;
+
+    DEBUG('a', "New shared text for file %d, %d pages\n", image->key,
+	numPages);
+    sprintf(fileName, "text%d", nextId++);
+    fileSystem->Create(fileName, size);
+    file = fileSystem->Open(fileName);
+    ASSERT(file != NULL);
+    file->WriteAt(image->Page(firstPage), size, 0);
+}
+
+//----------------------------------------------------------------------
+// SharedText::~SharedText
+// 	De-allocate the shared text, and throw away its backing file.
+//----------------------------------------------------------------------
+
+SharedText::~SharedText()
+{
+    delete [] frames;
+    delete [] users;
+    delete file;
+    fileSystem->Remove(fileName);
+}
+
+//----------------------------------------------------------------------
+// SharedText::AddUser
+// 	Record that an address space maps the shared pages, so that they
+//	can be unmapped from it when they are evicted.
+//----------------------------------------------------------------------
+
+void
+SharedText::AddUser(AddrSpace *space)
+{
+    AddrSpace **old;
+
+    if (numUsers == maxUsers) {
+	old = users;
+	maxUsers *= 2;
+	users = new AddrSpace*[maxUsers];
+	for (int i = 0; i < numUsers; i++)
+	    users[i] = old[i];
+	delete [] old;
+    }
+    users[numUsers++] = space;
+}
+
+//----------------------------------------------------------------------
+// SharedText::RemoveUser
+// 	An address space is going away.  When the last user of the shared
+//	text leaves, its frames are freed, and the shared text deleted.
+//----------------------------------------------------------------------
+
+void
+SharedText::RemoveUser(AddrSpace *space)
+{
+    int i;
+
+    for (i = 0; i < numUsers; i++)
+	if (users[i] == space)
+	    break;
+    ASSERT(i < numUsers);
+    users[i] = users[--numUsers];
+    if (numUsers > 0)
+	return;
+
+    DEBUG('a', "Last user of the text of file %d is gone\n", image->key);
+    for (i = 0; i < numPages; i++)
+	if (frames[i] != -1)
+	    frameTable->FreeFrame(frames[i]);
+    for (i = 0; i < MaxSharedTexts; i++)
+	if (table[i] == this)
+	    table[i] = NULL;
+    delete this;
+}
+
+//----------------------------------------------------------------------
+// SharedText::Fault
+// 	Return the frame holding a shared page, allocating one and reading
+//	the page in if no process has it in memory.
+//
+//	"vpn" is the faulting virtual page
+//----------------------------------------------------------------------
+
+int
+SharedText::Fault(int vpn)
+{
+    int page = vpn - firstPage;
+    int frame;
+
+    ASSERT(Contains(vpn));
+    if (frames[page] == -1) {
+	frame = frameTable->AllocateTextFrame(this, vpn);
+	file->ReadAt(&machine->mainMemory[frame * PageSize], PageSize,
+		page * PageSize);
+	frames[page] = frame;
+	DEBUG('a', "Shared text page %d read into frame %d\n", vpn, frame);
+    }
+    return frames[page];
+}
+
+//----------------------------------------------------------------------
+// SharedText::Referenced
+// 	Return TRUE if any user has referenced a shared page since the
+//	last call, and clear the use bits.  Used by the clock algorithm.
+//----------------------------------------------------------------------
+
+bool
+SharedText::Referenced(int vpn)
+{
+    TranslationEntry *entry;
+    bool used = FALSE;
+
+    for (int i = 0; i < numUsers; i++) {
+	entry = users[i]->PageEntry(vpn);
+	if (entry != NULL && entry->valid && entry->use) {
+	    used = TRUE;
+	    entry->use = FALSE;
+	}
+    }
+    return used;
+}
+
+//----------------------------------------------------------------------
+// SharedText::Evict
+// 	Unmap a shared page from every user.  It is never dirty, so there
+//	is nothing to write back; the caller frees the frame.
+//----------------------------------------------------------------------
+
+void
+SharedText::Evict(int vpn)
+{
+    TranslationEntry *entry;
+    int page = vpn - firstPage;
+
+    ASSERT(frames[page] != -1);
+    for (int i = 0; i < numUsers; i++) {
+	entry = users[i]->PageEntry(vpn);
+	if (entry != NULL && entry->valid && entry->physicalPage == frames[page])
+	    users[i]->Unmap(vpn);
+    }
+    frames[page] = -1;
+}
@@ -0,0 +1,77 @@
+// sharedtext.h
+//	Data structures to share the code pages of an executable between
+//	all the address spaces running it.
+//
+//	Code is never written, so every process running the same program
+//	can map the same physical frames, read-only.  A SharedText holds
+//	those frames for one executable, identified by its cached image:
+//	once the file is rewritten, new processes get a new image, and so
+//	do not share the old code.  It keeps its own copy of the code pages
+//	in a backing file, so each page is read in once, whoever faults on
+//	it first, and can be dropped and read back in like any other page.
+//	The backing file is filled from the image.
+//
+//	When the frame table evicts a shared page, it is unmapped from
+//	every address space using it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SHAREDTEXT_H
+#define SHAREDTEXT_H
+
+#include "copyright.h"
+#include "openfile.h"
+
+#define MaxSharedTexts	16	// executables whose code can be shared
+				// at the same time
+
+class AddrSpace;
+class ExecImage;
+
+// The following class defines the shared code of one executable,
+// covering the virtual pages [firstPage, firstPage + numPages).  The
+// frame table lock must be held to use it.
+
+class SharedText {
+  public:
+    static SharedText *Attach(ExecImage *image, int firstPage,
+			int numPages);
+					// Find the shared text of an
+					// executable, creating it if this
+					// is the first process to run it;
+					// NULL if it cannot be shared
+
+    void AddUser(AddrSpace *space);	// "space" maps the shared pages
+    void RemoveUser(AddrSpace *space);	// "space" is going away; the
+					// last user frees the shared text
+
+    bool Contains(int vpn) { return vpn >= firstPage &&
+					vpn < firstPage + numPages; }
+    int Fault(int vpn);			// Return the frame holding "vpn",
+					// reading it in if needed
+    bool Referenced(int vpn);		// Has any user touched "vpn" since
+					// the last call?  Clears use bits
+    void Evict(int vpn);		// Unmap "vpn" from every user; the
+					// frame table frees the frame
+
+  private:
+    SharedText(ExecImage *image, int firstPage, int numPages);
+    ~SharedText();
+
+    ExecImage *image;			// the executable; the users hold
+					// it as long as the text exists
+    int firstPage, numPages;		// the shared virtual pages
+    int *frames;			// frame of each page, -1 if the
+					// page is not in memory
+    AddrSpace **users;			// address spaces mapping the pages
+    int numUsers, maxUsers;
+    OpenFile *file;			// backing store for the code pages
+    char fileName[32];
+
+    static SharedText *table[MaxSharedTexts];
+    static int nextId;			// used to name the backing files
+};
+
+#endif // SHAREDTEXT_H
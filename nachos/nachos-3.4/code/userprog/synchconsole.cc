@@ -0,0 +1,145 @@
+// synchconsole.cc 
+//	Routines to synchronously access the console.  The physical
+//	console is an asynchronous device (requests return immediately,
+//	and an interrupt happens later on).  This is a layer on top of
+//	the console providing a synchronous interface (requests wait
+//	until the request completes), like the synchronous disk.
+//
+//	Use a semaphore to synchronize the interrupt handlers with the
+//	pending requests, and locks so that only one thread reads, and
+//	one writes, at a time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchconsole.h"
+
+//----------------------------------------------------------------------
+// ConsoleReadAvail, ConsoleWriteDone
+// 	Console interrupt handlers.  Need this to be a C routine, because 
+//	C++ can't handle pointers to member functions.
+//----------------------------------------------------------------------
+
+static void
+ConsoleReadAvail (int arg)
+{
+    SynchConsole* console = (SynchConsole *)arg;
+
+    console->ReadAvail();
+}
+
+static void
+ConsoleWriteDone (int arg)
+{
+    SynchConsole* console = (SynchConsole *)arg;
+
+    console->WriteDone();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::SynchConsole
+// 	Initialize the synchronous interface to the console, in turn
+//	initializing the console device.
+//
+//	"readFile", "writeFile" are the UNIX files simulating the keyboard
+//	and the display; NULL for stdin and stdout
+//----------------------------------------------------------------------
+
+SynchConsole::SynchConsole(char *readFile, char *writeFile)
+{
+    readAvail = new Semaphore("console read avail", 0);
+    writeDone = new Semaphore("console write done", 0);
+    readLock = new Lock("console read lock");
+    writeLock = new Lock("console write lock");
+    lineStart = lineEnd = 0;
+    console = new Console(readFile, writeFile, ConsoleReadAvail,
+	ConsoleWriteDone, (int) this);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::~SynchConsole
+// 	De-allocate data structures needed for the synchronous console
+//	abstraction.
+//----------------------------------------------------------------------
+
+SynchConsole::~SynchConsole()
+{
+    delete console;
+    delete writeLock;
+    delete readLock;
+    delete writeDone;
+    delete readAvail;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Read
+// 	Read characters typed at the console.  If nothing is left of the
+//	last line, wait until a new line is typed (or the line buffer is
+//	full), then return as much of it as fits.  A Read never returns
+//	characters from two lines, so a program reading a line at a time
+//	gets exactly one.
+//
+//	"buffer", "size" are where to put the characters, and how many
+//	fit; returns the number read
+//----------------------------------------------------------------------
+
+int
+SynchConsole::Read(char *buffer, int size)
+{
+    int count;
+    char ch;
+
+    readLock->Acquire();
+    if (lineStart == lineEnd) {
+	lineStart = lineEnd = 0;
+	do {
+	    readAvail->P();		// one V per character typed
+	    ch = console->GetChar();
+	    line[lineEnd++] = ch;
+	} while (ch != '\n' && lineEnd < ConsoleLineSize);
+    }
+    count = min(size, lineEnd - lineStart);
+    bcopy(&line[lineStart], buffer, count);
+    lineStart += count;
+    readLock->Release();
+    return count;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Write
+// 	Write a buffer to the console, waiting for each character to go
+//	out before sending the next one.
+//
+//	"buffer", "size" are the characters to write
+//----------------------------------------------------------------------
+
+void
+SynchConsole::Write(char *buffer, int size)
+{
+    writeLock->Acquire();
+    for (int i = 0; i < size; i++) {
+	console->PutChar(buffer[i]);
+	writeDone->P();
+    }
+    writeLock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::ReadAvail, SynchConsole::WriteDone
+// 	Console interrupt handlers.  Wake up the thread waiting for the
+//	device.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::ReadAvail()
+{
+    readAvail->V();
+}
+
+void
+SynchConsole::WriteDone()
+{
+    writeDone->V();
+}
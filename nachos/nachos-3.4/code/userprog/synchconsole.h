@@ -0,0 +1,55 @@
+// synchconsole.h 
+//	Data structures for synchronous access to the console, shared by
+//	all the threads of all user programs.
+//
+//	The console device is asynchronous, and handles one character at
+//	a time.  The synchronous console waits for each character, and
+//	moves whole buffers: input is collected a line at a time, and
+//	handed out from the line buffer by Read, so that a program can
+//	read a line with one system call; Write puts out a whole buffer
+//	under one lock, so that the output of different threads is not
+//	interleaved within a call.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHCONSOLE_H
+#define SYNCHCONSOLE_H
+
+#include "copyright.h"
+#include "console.h"
+#include "synch.h"
+
+#define ConsoleLineSize	128	// longest input line; longer ones are
+				// handed out in pieces
+
+// The following class defines a synchronous console.
+
+class SynchConsole {
+  public:
+    SynchConsole(char *readFile, char *writeFile);
+					// Initialize the console device;
+					// NULL means stdin and stdout
+    ~SynchConsole();
+
+    int Read(char *buffer, int size);	// Read up to "size" characters, but
+					// not past the end of a line;
+					// waits for a whole line to be
+					// typed, if none is buffered
+    void Write(char *buffer, int size);	// Write "size" characters
+
+    void ReadAvail();			// Called by the interrupt handlers
+    void WriteDone();
+
+  private:
+    Console *console;			// the raw device
+    Semaphore *readAvail;		// a character has come in
+    Semaphore *writeDone;		// a character has gone out
+    Lock *readLock, *writeLock;		// one reader, one writer at a time
+
+    char line[ConsoleLineSize];		// the input line being handed out
+    int lineStart, lineEnd;		// the part not read yet
+};
+
+#endif // SYNCHCONSOLE_H
@@ -29,6 +29,24 @@
 #define SC_Close	8
 #define SC_Fork		9
 #define SC_Yield	10
+#define SC_Mmap		11
+#define SC_Munmap	12
+#define SC_ThreadCreate	13
+#define SC_ThreadExit	14
+#define SC_LockCreate	15
+#define SC_LockDestroy	16
+#define SC_LockAcquire	17
+#define SC_LockRelease	18
+#define SC_CondCreate	19
+#define SC_CondDestroy	20
+#define SC_CondWait	21
+#define SC_CondSignal	22
+#define SC_CondBroadcast 23
+#define SC_Pipe		24
+#define SC_RingSetup	25
+#define SC_RingSubmit	26
+#define SC_Sbrk		27
+#define SC_UpcallSetup	28
 
 #ifndef IN_ASM
 
@@ -55,12 +73,13 @@ void Exit(int status);
 typedef int SpaceId;	
 
 /* Run the executable, stored in the Nachos file "name", and return the 
- * address space identifier
+ * address space identifier (0 if the program could not be started)
  */
 SpaceId Exec(char *name);
  
 /* Only return once the the user program "id" has finished.  
- * Return the exit status.
+ * Return the exit status.  Only the parent of "id" can join with it,
+ * and only once; otherwise Join returns -1 at once.
  */
 int Join(SpaceId id); 	
  
@@ -90,7 +109,9 @@ typedef int OpenFileId;
 void Create(char *name);
 
 /* Open the Nachos file "name", and return an "OpenFileId" that can 
- * be used to read and write to the file.
+ * be used to read and write to the file, or -1 if it cannot be opened.
+ * A process started by Exec or Fork inherits the open files of its
+ * parent.
  */
 OpenFileId Open(char *name);
 
@@ -102,12 +123,21 @@ void Write(char *buffer, int size, OpenFileId id);
  * long enough, or if it is an I/O device, and there aren't enough 
  * characters to read, return whatever is available (for I/O devices, 
  * you should always wait until you can return at least one character).
+ * The console is line buffered: a Read of ConsoleInput waits for a
+ * whole line, and never returns characters from more than one line.
  */
 int Read(char *buffer, int size, OpenFileId id);
 
 /* Close the file, we're done reading and writing to it. */
 void Close(OpenFileId id);
 
+/* Create a pipe: put an "OpenFileId" for its read end in fds[0], and
+ * one for its write end in fds[1].  Return 0, or -1 on error.  Read on
+ * an empty pipe waits for data, and returns 0 once every write end is
+ * closed; Write on a full pipe waits for room.
+ */
+int Pipe(OpenFileId *fds);
+
 
 
 /* User-level thread operations: Fork and Yield.  To allow multiple
@@ -124,6 +154,125 @@ void Fork(void (*func)());
  */
 void Yield();		
 
+
+/* Memory-mapped files: Mmap and Munmap. */
+
+/* Map "length" bytes of the open file, starting at "offset" (a multiple
+ * of the page size), into the address space, and return the address
+ * where they appear, or -1 on error.  Pages are read from the file when
+ * first touched, and stores to them are written back to the file; every
+ * process mapping the same file sees the same pages.
+ */
+int Mmap(OpenFileId id, int offset, int length);
+
+/* Remove the mapping that starts at "addr", writing back modified pages.
+ * Return 0, or -1 if nothing is mapped at "addr".
+ */
+int Munmap(int addr);
+
+/* Grow the heap by "delta" bytes (shrink it, if negative), and return
+ * the old end of the heap, or (void *) -1 if there is no room.  New
+ * memory reads as zeroes.  The stack grows by itself, as it is used.
+ */
+void *Sbrk(int delta);
+
+
+/* Threads within a process: ThreadCreate and ThreadExit.  All the
+ * threads of a process share its address space; each has a stack of its
+ * own.  The process exits when the last of its threads is done, by
+ * returning from main or from its procedure, or by calling Exit or
+ * ThreadExit.
+ */
+
+/* Create a thread to run "func(arg)".  Return a thread identifier, or
+ * -1 if the process has too many threads.
+ */
+int ThreadCreate(void (*func)(int), int arg);
+
+/* The calling thread is done. */
+void ThreadExit();
+
+/* Upcalls, for user-level thread packages that multiplex their threads
+ * over the threads of the process.  Once "func" is registered, whenever
+ * a thread blocks in a system call, the kernel creates a new thread
+ * that calls "func(blocked)", with the identifier of the thread that
+ * blocked, so the package can run another of its threads meanwhile.  The
+ * blocked thread returns from its system call as usual, when it is done.
+ * The new thread ends by returning from "func", or calling ThreadExit.
+ * Return 0.
+ */
+int UpcallSetup(void (*func)(int));
+
+
+/* Synchronization between the threads of a process: locks and condition
+ * variables, with the semantics of the kernel ones (see synch.h).  Each
+ * is named by an identifier local to the process.  The operations
+ * return 0, or -1 if an identifier is bad, or the lock is not held by
+ * the caller where it must be.
+ */
+
+/* Create a lock or condition variable; return its identifier, or -1. */
+int LockCreate();
+int CondCreate();
+
+/* Destroy a lock or condition variable nobody is using; -1 if a lock
+ * is held or waited for, or a thread waits on the condition.
+ */
+int LockDestroy(int lock);
+int CondDestroy(int cond);
+
+int LockAcquire(int lock);
+int LockRelease(int lock);
+
+/* "lock" must be held; Wait releases it while it sleeps. */
+int CondWait(int cond, int lock);
+int CondSignal(int cond, int lock);
+int CondBroadcast(int cond, int lock);
+
+
+/* Submission rings: many file operations for one system call.
+ *
+ * A program sets up a SyscallRing in its memory and registers it with
+ * RingSetup.  To queue an operation, it fills in sq[sqTail % RingSize]
+ * and increments sqTail; RingSubmit then carries out every queued
+ * operation, in order, and for each one fills in cq[cqTail % RingSize]
+ * with the result the system call would have returned (0 for those
+ * that return nothing), and increments sqHead and cqTail.  The program
+ * takes completions by incrementing cqHead.  RingSubmit stops early if
+ * the completion queue is full.
+ *
+ * Only Create, Open, Read, Write and Close may be queued; "opcode" is
+ * their SC_ code, and arg1 to arg3 their arguments.
+ */
+
+#define RingSize	32	/* entries in each queue; a power of 2 */
+
+typedef struct {
+    int opcode;
+    int arg1, arg2, arg3;
+    int userData;		/* handed back in the completion */
+} RingRequest;
+
+typedef struct {
+    int userData;
+    int result;
+} RingCompletion;
+
+typedef struct {
+    int sqHead, sqTail;		/* submission queue indices */
+    int cqHead, cqTail;		/* completion queue indices */
+    RingRequest sq[RingSize];
+    RingCompletion cq[RingSize];
+} SyscallRing;
+
+/* Register "ring"; return 0, or -1 if the address is bad. */
+int RingSetup(SyscallRing *ring);
+
+/* Carry out the queued operations; return how many, or -1 if no ring
+ * is registered.
+ */
+int RingSubmit();
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */